@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <tc/core.hpp>
+#include <tc/groups.hpp>
+
+/// every subset of the generators, as for the f-vector of a uniform polytope.
+std::vector<std::vector<size_t>> parabolics(size_t rank) {
+    std::vector<std::vector<size_t>> res;
+    for (size_t mask = 0; mask < (size_t(1) << rank); ++mask) {
+        auto &gens = res.emplace_back();
+        for (size_t gen = 0; gen < rank; ++gen) {
+            if (mask & (size_t(1) << gen)) gens.push_back(gen);
+        }
+    }
+    return res;
+}
+
+void bench(const std::string &group_expr, const std::string &symbol, unsigned max_threads) {
+    tc::Group<> group = tc::coxeter(symbol);
+    auto subsets = parabolics(group.rank());
+
+    double serial = 0;
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        auto s = std::chrono::steady_clock::now();
+        auto solved = group.solve_all(subsets, SIZE_MAX, threads);
+        auto e = std::chrono::steady_clock::now();
+
+        size_t cosets = 0;
+        for (auto const &table: solved) {
+            cosets += table.order();
+        }
+
+        auto time = std::chrono::duration<double>(e - s).count();
+        if (threads == 1) serial = time;
+
+        fmt::print(
+            "{:>12},{:>8},{:>12},{:>8},{:>8.3f}s,{:>8.2f}x\n",
+            group_expr, subsets.size(), cosets, threads, time, serial / time
+        );
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i + 1 < args.size(); ++i) {
+        if (args[i] == "--threads") max_threads = std::stoul(args[i + 1]);
+    }
+
+    fmt::print(
+        "{:>12},{:>8},{:>12},{:>8},{:>9},{:>9}\n",
+        "NAME", "SUBSETS", "COSETS", "THREADS", "TIME", "SPEEDUP"
+    );
+
+    bench("B_6", "4 3 * 4", max_threads);
+    bench("D_7", "3 * [1 1 4]", max_threads);
+    bench("E_6", "3 * [1 2 2]", max_threads);
+    bench("H_4", "5 3 3", max_threads);
+    bench("A_8", "3 * 7", max_threads);
+
+    return EXIT_SUCCESS;
+}
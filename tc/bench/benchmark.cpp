@@ -1,4 +1,7 @@
-#include <ctime>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
 #include <string>
 #include <vector>
 
@@ -8,6 +11,59 @@
 #include <tc/core.hpp>
 #include <tc/groups.hpp>
 
+/// number of heap allocations made by the whole program, including the tc library.
+static std::atomic<size_t> allocations = 0;
+
+/// worker threads passed to solve; set with --threads N. 1 runs the serial solver.
+static unsigned threads = 1;
+
+/// strategies to run each group with; --compare runs every strategy, one row each.
+static std::vector<tc::Strategy> strategies = {tc::Strategy::Felsch};
+
+/// directory for out-of-core tables; set with --scratch DIR. Empty keeps tables on the heap.
+static std::string scratch;
+
+/// use the enumeration kernels compiled for each rank; --generic runs the kernel for any rank instead.
+static bool specialize = true;
+
+void *operator new(size_t size) {
+    allocations++;
+    if (void *ptr = std::malloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+tc::Cosets<> solve(
+    const tc::Group<> &group,
+    const std::vector<size_t> &gens,
+    const size_t bound,
+    tc::Strategy strategy
+) {
+    if (threads > 1) {
+        return group.solve(gens, bound, threads);
+    }
+
+    tc::SolveOptions options;
+    options.bound = bound;
+    options.specialize = specialize;
+
+    if (!scratch.empty()) {
+        tc::SolverWorkspace workspace(scratch);
+        return group.solve(gens, options, workspace);
+    }
+    if (strategy == tc::Strategy::Felsch) {
+        return group.solve(gens, options);
+    }
+    return group.solve(gens, bound, strategy);
+}
+
 void bench(
     const std::string &group_expr,
     const std::string &symbol,
@@ -15,29 +71,73 @@ void bench(
     const size_t bound = SIZE_MAX
 ) {
     tc::Group<> group = tc::coxeter(symbol);
-    
-    std::clock_t s = std::clock();
-    tc::Cosets<> cosets = group.solve(gens, bound);
-    std::clock_t e = std::clock();
 
-    auto time = (double) (e - s) / CLOCKS_PER_SEC;
-    size_t order = cosets.order();
-    auto cos_s = (size_t) (order / time);
+    for (auto strategy: strategies) {
+        size_t a = allocations;
+        auto s = std::chrono::steady_clock::now();
+        tc::Cosets<> cosets = solve(group, gens, bound, strategy);
+        auto e = std::chrono::steady_clock::now();
+        size_t allocs = allocations - a;
 
-    bool complete = cosets.complete();
+        auto time = std::chrono::duration<double>(e - s).count();
+        size_t order = cosets.order();
+        auto cos_s = (size_t) (order / time);
 
-    std::string name = fmt::format("{}/{}", group_expr, gens);
-    std::string row = fmt::format(
-        "{:>24},{:>10},{:>6},{:>8.3f}s,{:>10L}",
-        name, order, complete, time, cos_s
-    );
-    fmt::print("{}\n", row);
+        bool complete = cosets.complete();
+        size_t width = cosets.width();
+
+        std::string name = fmt::format("{}/{}", group_expr, gens);
+        char const *label = strategy == tc::Strategy::HLT     ? "HLT"
+                            : strategy == tc::Strategy::Stamp ? "Stamp"
+                                                              : "Felsch";
+        std::string row = fmt::format(
+            "{:>24},{:>8},{:>10},{:>6},{:>8.3f}s,{:>10L},{:>10L},{:>6}",
+            name, label, order, complete, time, cos_s, allocs, width
+        );
+        fmt::print("{}\n", row);
+
+        // see Group<>::solve with threads: only finite tables below the bound are solved in parallel.
+        if (threads > 1) {
+            auto known = group.order(gens);
+            if (!known || *known >= bound) {
+                fmt::print("{:>24}  serial fallback: the table is infinite or reaches the bound\n", "");
+            }
+        }
+
+#ifdef TC_STATS
+        auto const &stats = cosets.stats();
+        fmt::print(
+            "{:>24}  facts pushed {} popped {} skipped {}, idempotent rows {}, max facts {}, max live rows {}, "
+            "loops closed {}\n",
+            "", stats.facts_pushed, stats.facts_popped, stats.facts_skipped, stats.idempotent_rows, stats.max_facts,
+            stats.max_live_rows, stats.loops_closed
+        );
+#endif
+    }
 }
 
 int main(int argc, char *argv[]) {
     std::vector<std::string> args(argv + 1, argv + argc);
 
-    fmt::print("{:>24},{:>10},{:>6},{:>9},{:>10}\n", "NAME", "ORDER", "COMPL", "TIME", "COS/S");
+    for (size_t i = 0; i + 1 < args.size(); ++i) {
+        if (args[i] == "--threads") threads = std::stoul(args[i + 1]);
+        if (args[i] == "--scratch") scratch = args[i + 1];
+    }
+    for (auto const &arg: args) {
+        if (arg == "--compare") strategies = {tc::Strategy::Felsch, tc::Strategy::HLT, tc::Strategy::Stamp};
+        if (arg == "--generic") specialize = false;
+    }
+
+    // the threaded and out-of-core solves only run Felsch, so they cannot measure the other strategies.
+    if ((threads > 1 || !scratch.empty()) && strategies.size() > 1) {
+        fmt::print(stderr, "--compare cannot be combined with --threads or --scratch\n");
+        return EXIT_FAILURE;
+    }
+
+    fmt::print(
+        "{:>24},{:>8},{:>10},{:>6},{:>9},{:>10},{:>10},{:>6}\n",
+        "NAME", "STRATEGY", "ORDER", "COMPL", "TIME", "COS/S", "ALLOCS", "WIDTH"
+    );
 
     // Finite Groups
     
@@ -59,7 +159,7 @@ int main(int argc, char *argv[]) {
     // E_n: 3 * [1 2 `n-4`]     ; n >= 6
     bench("E_6", "3 * [1 2 2]", {});
     bench("E_7", "3 * [1 2 3]", {});
-//    bench("E_8", "3 * [1 2 4]", {}); // too big
+    if (!scratch.empty()) bench("E_8", "3 * [1 2 4]", {}); // too big for RAM; run with --scratch
     // H_n: 5 3 * `n-2`         ; n >= 2
     bench("H_3", "5 3 * 0", {});
     bench("H_4", "5 3 * 1", {});
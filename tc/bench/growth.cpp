@@ -0,0 +1,51 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+
+#include <tc/core.hpp>
+#include <tc/groups.hpp>
+
+/// Time the growth series of a group, and print it with its first coefficients.
+void bench(std::string const &name, std::string const &symbol, size_t reps = 1000) {
+    tc::Group<> group = tc::coxeter(symbol);
+
+    tc::Growth growth;
+    auto s = std::chrono::steady_clock::now();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        growth = group.growth();
+    }
+    auto e = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(e - s).count() / double(reps);
+
+    fmt::print(
+        "{:>8},{:>10.1f},{:>6},{:>6},  {}\n",
+        name, us, growth.numer.size(), growth.denom.size(), growth.expand(8)
+    );
+}
+
+int main() {
+    fmt::print("{:>8},{:>10},{:>6},{:>6},  {}\n", "NAME", "US", "NUMER", "DENOM", "SERIES");
+
+    // the hyperbolic groups of benchmark.cpp
+    bench("-BH_3", "4 3 5");
+    bench("-K_3", "5 3 5");
+    bench("-J_3", "3 5 3");
+    bench("-DH_3", "5 3 * [1 1]");
+    bench("^AB_3", "{3 3 3 4}");
+    bench("^AH_3", "{3 3 3 5}");
+    bench("^BB_3", "{3 4 3 4}");
+    bench("^BH_3", "{3 4 3 5}");
+    bench("^HH_3", "{3 5 3 5}");
+    bench("-H_4", "5 3 3 3");
+    bench("-BH_4", "4 3 3 5");
+    bench("-K_4", "5 3 3 5");
+    bench("-DH_4", "5 3 3 * [1 1]");
+    bench("^AF_4", "{3 3 3 3 4}");
+
+    // for scale: a large finite group and an affine one.
+    bench("E_8", "3 * [1 2 4]");
+    bench("~E_8", "3 * [1 2 5]");
+}
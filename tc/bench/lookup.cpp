@@ -0,0 +1,55 @@
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include <tc/core.hpp>
+#include <tc/groups.hpp>
+
+enum class Mirror : int {
+    R, G, B, Y, C, M
+};
+
+/// Time every lookup in the table, in the order per-vertex loops make them; returns nanoseconds per lookup.
+template<typename Cosets, typename Gen>
+double time_lookups(Cosets const &cosets, std::vector<Gen> const &gens, size_t reps) {
+    size_t sum = 0;
+    auto s = std::chrono::steady_clock::now();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        for (size_t coset = 0; coset < cosets.order(); ++coset) {
+            for (auto const &gen: gens) {
+                sum += cosets.get(coset, gen);
+            }
+        }
+    }
+    auto e = std::chrono::steady_clock::now();
+
+    // keep the loop from being optimized away.
+    if (sum == 42) fmt::print("");
+
+    double lookups = double(reps) * double(cosets.order()) * double(gens.size());
+    return std::chrono::duration<double, std::nano>(e - s).count() / lookups;
+}
+
+template<typename Gen>
+void bench(std::string const &name, tc::Cosets<> const &raw, std::vector<Gen> const &gens, size_t reps) {
+    tc::Cosets<Gen> cosets(raw, gens);
+    fmt::print("{:>12},{:>10.2f}\n", name, time_lookups(cosets, gens, reps));
+}
+
+int main() {
+    tc::Cosets<> raw = tc::coxeter("3 3 3 3 3").solve({});
+    size_t reps = 50;
+
+    fmt::print("{:>12},{:>10}\n", "GEN", "NS/LOOKUP");
+
+    std::vector<size_t> idxs = {0, 1, 2, 3, 4, 5};
+    fmt::print("{:>12},{:>10.2f}\n", "raw", time_lookups(raw, idxs, reps));
+
+    bench<char>("char", raw, {'r', 'g', 'b', 'y', 'c', 'm'}, reps);
+    bench<int>("int", raw, {10, 20, 30, 40, 50, 60}, reps);
+    bench<Mirror>("enum", raw, {Mirror::R, Mirror::G, Mirror::B, Mirror::Y, Mirror::C, Mirror::M}, reps);
+    bench<long>("sparse int", raw, {1, 1000, 1000000, 1000000000, -1, -1000}, reps);
+    bench<std::string>("string", raw, {"red", "green", "blue", "yellow", "cyan", "magenta"}, reps);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <tc/core.hpp>
+
+namespace tc {
+    /**
+     * @brief Finite state automaton that accepts the ShortLex normal form of every element of a Coxeter group: of
+     * the reduced words for an element, the least by generator index. Walking it enumerates the elements without a
+     * coset table, so infinite groups can be listed to any word length in memory that does not grow with the length.
+     *
+     * States are sets of small roots, after Brink and Howlett. A root is small if it is simple, or if it is s(b) for
+     * a small root b and a simple reflection s with -1 < B(b, a_s) < 0. There are finitely many, so the automaton is
+     * finite and its size depends only on the diagram. States are built the first time they are reached. For a
+     * finite group, every element may have its own state, so enumerate finite groups with Group<>::solve instead.
+     *
+     * Not safe to use from several threads at once.
+     * @see Björner and Brenti, Combinatorics of Coxeter Groups, sections 4.7 and 4.8.
+     */
+    class Automaton {
+    public:
+        static constexpr size_t FAIL = SIZE_MAX;
+
+        explicit Automaton(Group<> const &group);
+
+        [[nodiscard]] size_t rank() const;
+
+        /// Number of small roots.
+        [[nodiscard]] size_t roots() const;
+
+        /// Number of states built so far.
+        [[nodiscard]] size_t states() const;
+
+        /// The state after <code>gen</code> is read in <code>state</code>, or FAIL if the word is no longer a normal
+        /// form. State 0 is the empty word.
+        [[nodiscard]] size_t next(size_t state, size_t gen);
+
+        /// Whether <code>word</code> is the normal form of its element.
+        [[nodiscard]] bool accepts(std::vector<size_t> const &word);
+
+        /**
+         * Pass the normal form of each element of length at most <code>max_length</code> to <code>visit</code>, in
+         * ShortLex order, stopping after <code>count</code> elements. Returns the number of elements visited.
+         *
+         * Each length is a separate depth-first pass, so memory holds only the automaton and the current word.
+         */
+        size_t walk(
+            size_t max_length, size_t count, std::function<void(std::vector<size_t> const &)> const &visit
+        );
+
+    private:
+        static constexpr size_t UNKNOWN = SIZE_MAX - 1;
+
+        size_t _rank;
+        size_t _roots;
+        size_t _width;                         // words of 64 bits per state
+        std::vector<size_t> _reflect;          // [root * rank + gen]: the small root gen sends root to, or FAIL
+        std::vector<uint64_t> _sets;           // [state * width]: the small roots in each state
+        std::vector<size_t> _next;             // [state * rank + gen]: next(), or UNKNOWN until first needed
+        std::unordered_map<std::string, size_t> _index;  // state by the bytes of its set
+
+        /// The state with the roots in <code>set</code>, built if it is new.
+        size_t intern(std::vector<uint64_t> const &set);
+    };
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <tc/core.hpp>
+
+namespace tc {
+    /**
+     * @brief Identifies a solve by the Coxeter matrix, the sorted and deduplicated subgroup generators, and the bound.
+     */
+    struct CacheKey {
+        std::vector<Mult> mults;
+        std::vector<size_t> idxs;
+        size_t bound;
+
+        CacheKey(Group<> const &group, std::vector<size_t> const &idxs, size_t bound);
+
+        /// 64-bit FNV-1a hash of the key.
+        [[nodiscard]] uint64_t hash() const;
+
+        bool operator==(CacheKey const &other) const = default;
+    };
+
+    /**
+     * @brief Store of solved tables. Attach one to a group with Group<>::use_cache and every solve of that group
+     * checks it first, and stores complete tables in it.
+     */
+    struct Cache {
+        virtual ~Cache() = default;
+
+        /// The table stored for <code>key</code>, if there is one.
+        [[nodiscard]] virtual std::optional<Cosets<>> load(CacheKey const &key) = 0;
+
+        virtual void store(CacheKey const &key, Cosets<> const &cosets) = 0;
+
+        /// The table stored for <code>key</code>, or null. By default this copies the table from load().
+        [[nodiscard]] virtual std::shared_ptr<Cosets<> const> load_shared(CacheKey const &key);
+
+        /// Store a table that callers may already share. By default this is store().
+        virtual void store_shared(CacheKey const &key, std::shared_ptr<Cosets<> const> const &cosets);
+    };
+
+    /**
+     * @brief Cache of tables as snapshot files in a directory, shared by every process that uses the directory.
+     *
+     * Tables are written to a temporary file and renamed into place, so readers never see a partial file. Loads map
+     * the file, see Cosets<>::map. Files are named by the hash of the key, so each file also records the subgroup and
+     * the bound after the table, and a load that finds a different key is a miss. Once the files exceed <code>max_bytes</code>, the least recently used are removed,
+     * though never the one just stored; a hit refreshes the modification time of its file.
+     */
+    class DiskCache : public Cache {
+    public:
+        DiskCache(std::string dir, size_t max_bytes);
+
+        [[nodiscard]] std::optional<Cosets<>> load(CacheKey const &key) override;
+
+        void store(CacheKey const &key, Cosets<> const &cosets) override;
+
+        /// The file that holds the table for <code>key</code>.
+        [[nodiscard]] std::string path(CacheKey const &key) const;
+
+    private:
+        std::string _dir;
+        size_t _max_bytes;
+
+        /// Remove the least recently used files other than <code>keep</code> until the directory fits.
+        void evict(std::string const &keep);
+    };
+
+    /**
+     * @brief In-process cache of tables, safe to use from several threads at once.
+     *
+     * Tables are kept as shared immutable objects, so Group<>::solve_shared hands out the same table to every caller;
+     * Group<>::solve copies it. Once the tables exceed <code>max_bytes</code>, the least recently used are dropped,
+     * though callers still holding one keep it alive. Misses are passed on to <code>next</code>, if given, and stores
+     * go to both; a MemoryCache in front of a DiskCache avoids remapping the same file.
+     *
+     * Two threads that miss on the same key at once both solve it.
+     */
+    class MemoryCache : public Cache {
+    public:
+        explicit MemoryCache(size_t max_bytes, std::shared_ptr<Cache> next = nullptr);
+
+        [[nodiscard]] std::optional<Cosets<>> load(CacheKey const &key) override;
+
+        void store(CacheKey const &key, Cosets<> const &cosets) override;
+
+        [[nodiscard]] std::shared_ptr<Cosets<> const> load_shared(CacheKey const &key) override;
+
+        void store_shared(CacheKey const &key, std::shared_ptr<Cosets<> const> const &cosets) override;
+
+        /// Loads served from memory.
+        [[nodiscard]] size_t hits() const;
+
+        /// Loads not served from memory, whether or not <code>next</code> had the table.
+        [[nodiscard]] size_t misses() const;
+
+        /// Bytes of table data held.
+        [[nodiscard]] size_t bytes() const;
+
+        /// Drop every table. The counters are kept.
+        void clear();
+
+    private:
+        struct Entry {
+            CacheKey key;
+            std::shared_ptr<Cosets<> const> cosets;
+            size_t bytes;
+        };
+
+        size_t _max_bytes;
+        std::shared_ptr<Cache> _next;
+
+        mutable std::mutex _mutex;
+        std::list<Entry> _entries;  // most recently used first
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> _index;
+        size_t _bytes = 0;
+
+        std::atomic<size_t> _hits = 0;
+        std::atomic<size_t> _misses = 0;
+
+        /// The table for <code>key</code> in memory, or null. Requires the lock.
+        [[nodiscard]] std::shared_ptr<Cosets<> const> find(CacheKey const &key);
+
+        /// Insert or replace the table for <code>key</code>, then drop tables until the rest fit. Requires the lock.
+        void insert(CacheKey const &key, std::shared_ptr<Cosets<> const> const &cosets);
+    };
+}
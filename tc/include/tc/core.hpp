@@ -1,15 +1,58 @@
 #pragma once
 
 #include <vector> //todo clean up includes. lots of duplicate cstdint, cassert.
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cassert>
+#include <tuple>
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+#include <tc/storage.hpp>
 
 namespace tc {
-    using Mult = u_int16_t;
+    using Mult = uint16_t;
     constexpr Mult FREE = 0;
 
+    /**
+     * @brief How Group<>::solve chooses which cosets to define.
+     * <ul>
+     *   <li>
+     *     <code>Felsch</code> defines the first unknown product and immediately propagates everything it implies, so
+     *     no coset is ever redundant. Memory is proportional to the order.
+     *   </li>
+     *   <li>
+     *     <code>HLT</code> scans each coset against every relation in turn, defining cosets to complete the scan.
+     *     This defines redundant cosets, which are merged when they are found to coincide. When the working table
+     *     fills, a lookahead pass finds coincidences without defining anything and the table is compacted.
+     *   </li>
+     *   <li>
+     *     <code>Stamp</code> works like HLT, but each relation (s_i s_j)^m is completed once per rank 2 residue: the
+     *     first scan that touches an orbit of <s_i, s_j> defines the whole orbit, and every coset on it is marked so
+     *     it is not scanned against that relation again. There is no lookahead; dead cosets are dropped whenever the
+     *     working table fills. A relation with large m costs O(m) per residue rather than O(m) per coset as in HLT,
+     *     so it is far faster than HLT on such groups. It is not faster than Felsch: about 2x slower on I2(10000)
+     *     and 3x slower on T(100).
+     *   </li>
+     * </ul>
+     * All return the same table; cosets are numbered in the order Felsch defines them. Felsch is the fastest on every
+     * group in bench_benchmark that takes long enough to time, so HLT and Stamp are for comparison.
+     */
+    enum class Strategy {
+        Felsch,
+        HLT,
+        Stamp,
+    };
+
     /**
      * @brief Mapping from "global" generator names or objects to indexes used for value lookup. 
      * @tparam Gen_ 
@@ -49,7 +92,92 @@ namespace tc {
      * @tparam Gen_ 
      */
     template<typename Gen_=void>
-    struct Path;  // todo not yet implemented
+    struct Path;
+
+    struct Cache;
+
+    struct Solver;
+
+    struct Table;
+
+    /**
+     * @brief Why a solve stopped. Every reason other than <code>Complete</code> leaves an incomplete table.
+     */
+    enum class StopReason {
+        Complete,
+        Bound,
+        Cancelled,
+        Deadline,
+        Memory,
+    };
+
+    /**
+     * @brief Snapshot of a running solve, passed to SolveOptions::progress.
+     */
+    struct Progress {
+        size_t cosets;  // cosets defined so far
+        size_t scan;    // cosets whose products are all known
+        size_t rows;    // cosets with relation rows still in use; cosets - scan
+    };
+
+    /**
+     * @brief Limits and reporting for a Felsch solve. The callbacks and the limits other than <code>bound</code> are
+     * checked once every <code>interval</code> new cosets, so they cost nothing between checks, and a solve may run
+     * up to one interval past a limit before it stops. A stopped solve returns an incomplete table, and
+     * Cosets<>::stop_reason says why.
+     */
+    struct SolveOptions {
+        /// Stop once the order reaches this.
+        size_t bound = SIZE_MAX;
+
+        /// Called at every check.
+        std::function<void(Progress const &)> progress = {};
+
+        /**
+         * Called at every check, and when the solve stops, with the rows that have become final since the last call:
+         * every product of cosets <code>[begin, end)</code> is known and will not change. Read them from
+         * <code>cosets</code> during the call; other rows may still be incomplete. Once a solve completes, every row
+         * has been passed exactly once, in order.
+         */
+        std::function<void(Cosets<> const &cosets, size_t begin, size_t end)> consumer = {};
+
+        /// Stop once this becomes true. It may be set from any thread.
+        std::atomic<bool> const *cancel = nullptr;
+
+        /// Stop once this time has passed.
+        std::optional<std::chrono::steady_clock::time_point> deadline = std::nullopt;
+
+        /// Stop once the table and solver buffers, in memory or in scratch files, exceed this many bytes.
+        size_t max_bytes = SIZE_MAX;
+
+        /// New cosets between checks.
+        size_t interval = size_t(1) << 14;
+
+        /// Use the enumeration kernels compiled for ranks 2 to 8. Disable only to compare with the generic kernel.
+        bool specialize = true;
+
+        /// Record the distance of each coset from coset 0 as it is defined; see Cosets<>::depth().
+        bool depth = false;
+
+        /// Record the coset and generator each coset is defined from; see Cosets<>::path().
+        bool path = false;
+    };
+
+#ifdef TC_STATS
+    /**
+     * @brief Counters from the Felsch enumeration loop, kept only when tc is built with <code>TC_STATS</code>.
+     * Tables from other strategies, or loaded from a file, report zeros.
+     */
+    struct SolveStats {
+        size_t facts_pushed = 0;
+        size_t facts_popped = 0;
+        size_t facts_skipped = 0;   // facts popped for a product that was already known
+        size_t idempotent_rows = 0;
+        size_t max_facts = 0;       // longest fact queue for one new coset
+        size_t max_live_rows = 0;   // most cosets between the scan and the newest coset
+        std::vector<size_t> loops_closed;  // per relation table: pairs i < j with 2 < m < inf, in order
+    };
+#endif
     
     template<>
     struct Index<> {
@@ -58,21 +186,166 @@ namespace tc {
         }
     };
 
+    /**
+     * @brief Index of each generator in <code>_gens</code>, found in constant time. Generators of one byte index a
+     * fixed table; other integers and enums index a table over the range of their values if it is small; anything
+     * else is hashed. Types without std::hash fall back to a linear search. A repeated generator has the index of its
+     * first occurrence, and a missing one the number of generators.
+     */
     template<typename Gen_>
     struct Index {
         using Gen = Gen_;
 
         std::vector<Gen> _gens{};
 
-//        explicit Index(std::vector<Gen> gens) : _gens(gens) {}
+        Index()
+            : Index(std::vector<Gen>{}) {}
+
+        explicit Index(std::vector<Gen> gens)
+            : _gens(std::move(gens)) {
+            size_t missing = _gens.size();
+
+            if constexpr (BYTE) {
+                _dense.assign(size_t(1) << 8, missing);
+            } else if constexpr (INTEGRAL) {
+                if (!_gens.empty()) {
+                    auto [lo, hi] = std::minmax_element(_gens.begin(), _gens.end(), [](Gen const &a, Gen const &b) {
+                        return Key(a) < Key(b);
+                    });
+                    _lo = uint64_t(Key(*lo));
+                    uint64_t range = uint64_t(Key(*hi)) - _lo;
+                    if (range < DENSE_MAX) _dense.assign(range + 1, missing);
+                }
+            }
+
+            // in reverse, so the first occurrence of a repeated generator is kept.
+            for (size_t idx = _gens.size(); idx-- > 0;) {
+                if (!_dense.empty()) {
+                    _dense[key(_gens[idx])] = idx;
+                } else if constexpr (HASHED) {
+                    _map[_gens[idx]] = idx;
+                }
+            }
+        }
 
         size_t operator()(Gen const &gen) const {
-            auto it = std::find(_gens.begin(), _gens.end(), gen);
-            assert(it != _gens.end());
-            return it - _gens.begin();
+            size_t idx = find(gen);
+            assert(idx != _gens.size());
+            return idx;
+        }
+
+    private:
+        static constexpr bool INTEGRAL = std::is_integral_v<Gen> || std::is_enum_v<Gen>;
+        static constexpr bool BYTE = INTEGRAL && sizeof(Gen) == 1;
+        static constexpr bool HASHED = requires(Gen const &gen) { std::hash<Gen>{}(gen); };
+
+        /// Integers and enums whose values span less than this are looked up in a table.
+        static constexpr uint64_t DENSE_MAX = 1 << 12;
+
+        using Key = typename std::conditional_t<
+            std::is_enum_v<Gen>, std::underlying_type<Gen>, std::type_identity<Gen>
+        >::type;
+
+        struct NoMap {};
+
+        std::vector<size_t> _dense;  // by key(); empty unless a table is used
+        uint64_t _lo = 0;            // smallest value, for integers and enums that are not bytes
+        std::conditional_t<HASHED, std::unordered_map<Gen, size_t>, NoMap> _map;
+
+        [[nodiscard]] size_t key(Gen const &gen) const {
+            if constexpr (BYTE) {
+                return uint8_t(Key(gen));
+            } else if constexpr (INTEGRAL) {
+                return uint64_t(Key(gen)) - _lo;
+            } else {
+                return 0;
+            }
+        }
+
+        [[nodiscard]] size_t find(Gen const &gen) const {
+            if constexpr (BYTE) {
+                return _dense[key(gen)];
+            } else {
+                if constexpr (INTEGRAL) {
+                    if (!_dense.empty()) {
+                        size_t k = key(gen);
+                        return k < _dense.size() ? _dense[k] : _gens.size();
+                    }
+                }
+                if constexpr (HASHED) {
+                    auto it = _map.find(gen);
+                    return it == _map.end() ? _gens.size() : it->second;
+                } else {
+                    return std::find(_gens.begin(), _gens.end(), gen) - _gens.begin();
+                }
+            }
         }
     };
 
+    /**
+     * @brief Breadth-first spanning tree of a coset table: for every coset but 0, the parent it was defined from and
+     * the generator that takes the parent to it. Felsch numbers cosets breadth-first, so each level of the tree is a
+     * contiguous range of cosets and every parent comes before its children.
+     */
+    template<>
+    struct Path<> {
+        /// Number of cosets in the tree.
+        [[nodiscard]] size_t order() const;
+
+        /// The coset that <code>coset</code> was defined from, or Cosets<>::UNSET for coset 0.
+        [[nodiscard]] size_t parent(size_t coset) const;
+
+        /// The generator that takes the parent of <code>coset</code> to it.
+        [[nodiscard]] size_t gen(size_t coset) const;
+
+        /// Number of levels. Level k holds the cosets at distance k from coset 0.
+        [[nodiscard]] size_t levels() const;
+
+        /// The first coset of <code>level</code>; <code>level(levels())</code> is the order.
+        [[nodiscard]] size_t level(size_t level) const;
+
+        /**
+         * @brief Give every coset a value: <code>start</code> for coset 0, and <code>op(value of parent, gens[gen])
+         * </code> for the rest. Levels are done in order, each split across <code>threads</code> threads, or one per
+         * core if <code>threads</code> is 0, so <code>op</code> must be safe to call from several threads at once.
+         */
+        template<typename T, typename E, typename Op>
+        [[nodiscard]] std::vector<T> walk(
+            T const &start, std::vector<E> const &gens, Op const &op, unsigned threads = 0
+        ) const {
+            std::vector<T> res(order());
+            if (res.empty()) return res;
+
+            res[0] = start;
+            each_level(threads, [&](size_t begin, size_t end) {
+                for (size_t coset = begin; coset < end; ++coset) {
+                    res[coset] = op(res[_parents[coset]], gens[_gens[coset]]);
+                }
+            });
+            return res;
+        }
+
+        friend Group<>;
+        friend Cosets<>;
+
+    private:
+        std::vector<size_t> _parents;
+        std::vector<uint16_t> _gens;
+        std::vector<size_t> _levels;  // first coset of each level
+
+        /// Start a tree with only coset 0.
+        void root();
+
+        /// Add the next coset, defined as <code>parent</code> times <code>gen</code>.
+        void add(size_t parent, size_t gen);
+
+        /**
+         * Call <code>op(begin, end)</code> on ranges of cosets [1, order) so that every parent is done before its
+         * children. Small levels are done in runs by one thread; large ones are split across the threads.
+         */
+        void each_level(unsigned threads, std::function<void(size_t, size_t)> const &op) const;
+    };
+
     template<>
     struct Cosets<> {
         static constexpr size_t UNSET = std::numeric_limits<size_t>::max();
@@ -81,7 +354,15 @@ namespace tc {
         size_t _rank;
         size_t _order;
         bool _complete;
-        std::vector<size_t> _data;
+        StopReason _stop;  // why an incomplete table stopped
+        size_t _width;
+        std::vector<Mult> _mults;
+        Storage _data;
+        std::vector<uint8_t> _depth;  // empty unless depths are recorded; entries are as wide as the table's
+        Path<> _path;                  // empty unless the path is recorded
+#ifdef TC_STATS
+        SolveStats _stats;
+#endif
 
     public:
         Cosets(Cosets const &) = default;
@@ -90,6 +371,22 @@ namespace tc {
 
         ~Cosets() = default;
 
+        /**
+         * @brief Load a table written by save(). The table is mapped, not read: get() is served straight from the
+         * page cache, so processes that map the same file share one physical copy. Throws
+         * <code>std::runtime_error</code> if the file is not a snapshot of this version.
+         */
+        static Cosets map(std::string const &path);
+
+        /**
+         * @brief Write the table to <code>path</code>: a versioned header with the rank, order, completeness, entry
+         * width and the group's Coxeter matrix, followed by the raw table.
+         */
+        void save(std::string const &path) const;
+
+        /// The group this table was solved for.
+        [[nodiscard]] Group<> group() const;
+
         void set(size_t coset, size_t gen, size_t target);
 
         [[nodiscard]] size_t get(size_t coset, size_t gen) const;
@@ -102,15 +399,78 @@ namespace tc {
 
         [[nodiscard]] bool complete() const;
 
+        /// Why the solve stopped. A table loaded by map() only records whether it is complete, so an incomplete one
+        /// reports <code>Bound</code>.
+        [[nodiscard]] StopReason stop_reason() const;
+
+#ifdef TC_STATS
+        [[nodiscard]] SolveStats const &stats() const;
+#endif
+
         [[nodiscard]] size_t size() const;
 
+        /// Whether the solve recorded depths, as requested by SolveOptions::depth.
+        [[nodiscard]] bool has_depth() const;
+
+        /**
+         * @brief The length of the shortest word that takes coset 0 to <code>coset</code>. Only recorded by a Felsch
+         * solve with SolveOptions::depth; otherwise throws <code>std::logic_error</code>. Depths are not saved by
+         * save().
+         */
+        [[nodiscard]] size_t depth(size_t coset) const;
+
+        /// Whether the solve recorded the spanning tree, as requested by SolveOptions::path.
+        [[nodiscard]] bool has_path() const;
+
+        /**
+         * @brief The breadth-first spanning tree of the table. Only recorded by a Felsch solve with
+         * SolveOptions::path; otherwise throws <code>std::logic_error</code>. Not saved by save().
+         */
+        [[nodiscard]] Path<> const &path() const;
+
+        /**
+         * @brief Bytes used by each entry of the table; 2, 4 or 8. This is the narrowest width that can index every
+         * coset, so small tables take a fraction of the memory of a <code>size_t</code> table.
+         */
+        [[nodiscard]] size_t width() const;
+
         friend Group<>;  // only constructible via Group<>::solve
 
     private:
-        explicit Cosets(size_t rank);
+        explicit Cosets(Group<> const &group);
 
         void add_row();
 
+        void reserve(size_t bytes);
+
+        /// Record the depth of every coset defined so far. The numbering is breadth-first, so each coset's parent is
+        /// its neighbour with the smallest index.
+        void record_depth();
+
+        /// Record the spanning tree of the cosets defined so far, as the solve would have.
+        void record_path();
+
+        /// Make the table hold <code>order</code> unset rows, at the narrowest width that can index them all.
+        void resize(size_t order);
+
+        /// Convert every entry to a wider index type, reserving at least <code>bytes</code> for the new table.
+        void promote(size_t width, size_t bytes = 0);
+
+        template<typename Idx>
+        [[nodiscard]] Idx *table() {
+            return reinterpret_cast<Idx *>(_data.data());
+        }
+
+        /// Record the depth of the newest coset, one more than that of <code>parent</code>. A depth is less than the
+        /// order, so it fits in Idx.
+        template<typename Idx>
+        void add_depth(size_t parent) {
+            size_t end = _depth.size();
+            _depth.resize(end + sizeof(Idx));
+            auto *depths = reinterpret_cast<Idx *>(_depth.data());
+            depths[end / sizeof(Idx)] = depths[parent] + 1;
+        }
+
         void set(size_t idx, size_t target);
 
         [[nodiscard]] size_t get(size_t idx) const;
@@ -118,6 +478,81 @@ namespace tc {
         [[nodiscard]] bool isset(size_t idx) const;
     };
 
+    /**
+     * @brief Scratch space for Group<>::solve. Reusing one workspace across solves keeps the relation tables and
+     * queues allocated, so repeated solves of similar size only allocate the returned table.
+     */
+    struct SolverWorkspace {
+        SolverWorkspace();
+
+        /**
+         * @brief Out-of-core workspace. The coset table and the relation rows live in unlinked scratch files under
+         * <code>scratch</code>, mapped into memory, so a solve is limited by disk space rather than RAM. Each
+         * returned table keeps its own scratch file until it is destroyed.
+         */
+        explicit SolverWorkspace(std::string const &scratch);
+
+        SolverWorkspace(SolverWorkspace &&) noexcept;
+
+        SolverWorkspace &operator=(SolverWorkspace &&) noexcept;
+
+        ~SolverWorkspace();
+
+        friend Group<>;
+
+    private:
+        struct State;
+        std::unique_ptr<State> _state;
+    };
+
+    /**
+     * @brief Kind of an irreducible Coxeter group, read from the signature of its Gram matrix
+     * <code>B_ij = -cos(pi / m_ij)</code>, with <code>-1</code> for free pairs. Finite groups have a positive definite
+     * matrix, affine groups a singular positive semidefinite one; everything else, hyperbolic or not, is
+     * <code>Other</code>. Only finite groups have a finite coset table over a proper standard parabolic subgroup.
+     */
+    enum class Kind {
+        Finite,
+        Affine,
+        Other,
+    };
+
+    /**
+     * @brief An irreducible component of a Coxeter diagram: a maximal set of generators connected by pairs with
+     * <code>m_ij != 2</code>. The group is the direct product of its components.
+     */
+    struct Component {
+        std::vector<size_t> gens;  // generators of the component, in index order
+        Kind kind = Kind::Other;
+
+        /// 'A', 'B', 'D', 'E', 'F', 'H' or 'I' for a finite component, otherwise 0. B_2 is 'B' and A_2 is 'A'; the
+        /// other dihedral groups, including H_2 and G_2, are 'I'.
+        char family = 0;
+
+        /// Degrees of the basic invariants of a finite component, whose product is its order; otherwise empty.
+        std::vector<size_t> degrees = {};
+
+        /// The order of a finite component, saturated at SIZE_MAX, or nothing if it is infinite.
+        [[nodiscard]] std::optional<size_t> order() const;
+
+        /// Type name such as "A3", "E8" or "I2(7)" for a finite component; "affine" or "other" otherwise.
+        [[nodiscard]] std::string name() const;
+    };
+
+    /**
+     * @brief Growth series of a coset space W/W_J: coefficient k counts the cosets whose shortest representatives have
+     * length k, which are the cosets at distance k from coset 0 in the table. The series is a rational function with
+     * integer coefficients, stored as its numerator and denominator, constant term first. The denominator has
+     * constant term 1, and is 1 exactly when W/W_J is finite.
+     */
+    struct Growth {
+        std::vector<int64_t> numer;
+        std::vector<int64_t> denom;
+
+        /// The first <code>count</code> coefficients. Throws <code>std::overflow_error</code> once they do not fit.
+        [[nodiscard]] std::vector<size_t> expand(size_t count) const;
+    };
+
     template<>
     struct Group<> {
         using Rel = std::tuple<size_t, size_t, Mult>;
@@ -125,6 +560,7 @@ namespace tc {
     private:
         size_t _rank;
         std::vector<size_t> _mults;
+        std::shared_ptr<Cache> _cache;
 
     public:
         Group(Group const &) = default;
@@ -143,7 +579,218 @@ namespace tc {
 
         [[nodiscard]] Group sub(std::vector<size_t> const &idxs) const;
 
+        /// The irreducible components of the diagram, ordered by their smallest generator.
+        [[nodiscard]] std::vector<Component> classify() const;
+
+        /**
+         * @brief The number of cosets of the subgroup generated by <code>idxs</code>, computed from the diagram
+         * without enumerating, or nothing if there are infinitely many. The count saturates at SIZE_MAX.
+         *
+         * A proper standard parabolic subgroup of an infinite irreducible group has infinite index, so the index is
+         * finite exactly when every infinite component lies in the subgroup.
+         */
+        [[nodiscard]] std::optional<size_t> order(std::vector<size_t> const &idxs = {}) const;
+
+        /**
+         * @brief The growth series of the cosets of the subgroup generated by <code>idxs</code>, computed from the
+         * finite standard parabolic subgroups by Steinberg's formula, without enumerating:
+         * <code>1 / W(t) = sum over finite W_T of (-1)^|T| t^N_T / W_T(t)</code>, where N_T is the length of the
+         * longest element of W_T. The series of W/W_J is W(t) / W_J(t), taken one irreducible component at a time.
+         * Common cyclotomic factors are cancelled, so finite coset spaces give a polynomial.
+         */
+        [[nodiscard]] Growth growth(std::vector<size_t> const &idxs = {}) const;
+
+        /**
+         * @brief Check <code>cache</code> before every solve of this group and store complete tables in it, or stop
+         * caching if <code>cache</code> is null. Copies of the group share the cache; subgroups from sub() do not.
+         * Parallel solves without <code>serial_order</code> number cosets differently, so they bypass the cache.
+         * @see DiskCache, MemoryCache
+         */
+        void use_cache(std::shared_ptr<Cache> cache);
+
+        [[nodiscard]] std::shared_ptr<Cache> cache() const;
+
+        /**
+         * @brief Felsch solve of the cosets of the subgroup generated by <code>idxs</code>, stopping once the order
+         * reaches <code>bound</code>. If order() knows the size of the table, it is allocated once at its final
+         * width. Every solve throws <code>std::invalid_argument</code> if there are infinitely many cosets and
+         * nothing would stop it: no bound, cancel flag, deadline or memory budget.
+         * @see Automaton to list the elements of an infinite group without a table.
+         */
         [[nodiscard]] Cosets<> solve(std::vector<size_t> const &idxs, size_t bound = SIZE_MAX) const;
+
+        [[nodiscard]] Cosets<> solve(std::vector<size_t> const &idxs, size_t bound, SolverWorkspace &workspace) const;
+
+        /// Felsch solve with progress reporting and the limits in <code>options</code>.
+        [[nodiscard]] Cosets<> solve(std::vector<size_t> const &idxs, SolveOptions const &options) const;
+
+        [[nodiscard]] Cosets<> solve(
+            std::vector<size_t> const &idxs, SolveOptions const &options, SolverWorkspace &workspace
+        ) const;
+
+        /**
+         * @brief Solve, or share the table the attached cache already holds. A MemoryCache hands out the same table
+         * to every caller without copying it.
+         */
+        [[nodiscard]] std::shared_ptr<Cosets<> const> solve_shared(
+            std::vector<size_t> const &idxs, size_t bound = SIZE_MAX
+        ) const;
+
+        /**
+         * @brief Solve using up to <code>threads</code> threads, or one per core if <code>threads</code> is 0.
+         *
+         * The table is assembled from a chain of standard parabolic subgroups, one generator apart, whose links are
+         * solved independently and then combined row by row. Only a finite table smaller than <code>bound</code>, one
+         * whose order() is known and below it, is solved in parallel. Infinite tables, such as the balls of affine and
+         * hyperbolic groups, and tables that reach <code>bound</code> fall back to the serial solve, so threads do
+         * not speed them up.
+         *
+         * Cosets are numbered by their position in the chain. With <code>serial_order</code> they are renumbered so
+         * the table is identical to the serial solve.
+         */
+        [[nodiscard]] Cosets<> solve(
+            std::vector<size_t> const &idxs, size_t bound, unsigned threads, bool serial_order = false
+        ) const;
+
+        [[nodiscard]] Cosets<> solve(std::vector<size_t> const &idxs, size_t bound, Strategy strategy) const;
+
+        /**
+         * @brief Assemble the table of W/W_J from the tables of W/W_K and W_K/W_J, for standard parabolic subgroups
+         * J of K, without enumerating W/W_J. Uses up to <code>threads</code> threads, or one per core if
+         * <code>threads</code> is 0.
+         *
+         * <code>outer</code> is a complete table of this group over some W_K, and <code>inner</code> a complete table
+         * of <code>sub(K)</code>, with K in index order, over some W_J; both subgroups are read from the tables. The
+         * order is the product of the two orders. Coset <code>a * inner.order() + b</code> is the product of coset a
+         * of <code>outer</code> and coset b of <code>inner</code>. With <code>serial_order</code> the cosets are
+         * renumbered so the table is identical to the serial solve.
+         *
+         * Throws <code>std::invalid_argument</code> if the tables do not fit together.
+         */
+        [[nodiscard]] Cosets<> compose(
+            Cosets<> const &outer, Cosets<> const &inner, bool serial_order = false, unsigned threads = 0
+        ) const;
+
+        /**
+         * @brief Solve every subset of generators, on up to <code>threads</code> threads, or one per core if
+         * <code>threads</code> is 0. Each worker keeps its own SolverWorkspace, and the relation setup is shared by
+         * all of them. The tables are returned in the order of <code>subsets</code>.
+         */
+        [[nodiscard]] std::vector<Cosets<>> solve_all(
+            std::vector<std::vector<size_t>> const &subsets, size_t bound = SIZE_MAX, unsigned threads = 0
+        ) const;
+
+    private:
+        /// The cached table for this solve, if a cache is attached and has one.
+        [[nodiscard]] std::optional<Cosets<>> cache_load(std::vector<size_t> const &idxs, size_t bound) const;
+
+        /// Store a complete table in the attached cache, if any.
+        void cache_store(std::vector<size_t> const &idxs, size_t bound, Cosets<> const &cosets) const;
+
+        /// A complete table assembled from a chain of labelled links, as in the parallel solve.
+        template<typename Links>
+        [[nodiscard]] Cosets<> combine(Links const &links, size_t order, unsigned threads, bool serial_order) const;
+
+        /// order() over the given classification of this group.
+        [[nodiscard]] std::optional<size_t> order(
+            std::vector<size_t> const &idxs, std::vector<Component> const &components
+        ) const;
+
+        /// Felsch enumeration, without the cache. <code>known</code> is the order check_stops() predicted.
+        [[nodiscard]] Cosets<> solve_felsch(
+            std::vector<size_t> const &idxs, std::optional<size_t> known, SolveOptions const &options,
+            SolverWorkspace &workspace
+        ) const;
+
+        /// Throw <code>std::invalid_argument</code> if a solve with <code>options</code> would never stop.
+        void check_stops(std::vector<size_t> const &idxs, SolveOptions const &options) const;
+
+        /**
+         * As above, and return order(idxs) for start(). The relations and the classification of this group are kept
+         * in <code>workspace</code>, and the prediction for the last subgroup is reused, so a repeated solve does not
+         * classify the diagram again.
+         */
+        std::optional<size_t> check_stops(
+            std::vector<size_t> const &idxs, SolveOptions const &options, SolverWorkspace &workspace
+        ) const;
+
+        /**
+         * A table holding only the initial coset, with the relation tables in <code>workspace</code> set up for it.
+         * If the order is <code>known</code>, the table is reserved for <code>min(order, bound)</code> cosets at the
+         * width they need. check_stops() must have set up <code>workspace</code> for this group first.
+         */
+        [[nodiscard]] Cosets<> start(
+            std::vector<size_t> const &idxs, std::optional<size_t> known, size_t bound, SolverWorkspace &workspace
+        ) const;
+
+        /**
+         * Continue a Felsch enumeration from the unknown product <code>idx</code> until it completes or stops at one
+         * of the limits in <code>options</code>. <code>cosets</code> and <code>workspace</code> must be left as
+         * start() or an earlier resume() left them.
+         */
+        void resume(Cosets<> &cosets, SolverWorkspace &workspace, size_t &idx, SolveOptions const &options) const;
+
+        /**
+         * HLT enumeration with lookahead. Falls back to the Felsch solve if the live cosets reach the bound, since
+         * only Felsch defines which cosets an incomplete table contains.
+         */
+        [[nodiscard]] Cosets<> solve_hlt(std::vector<size_t> const &idxs, size_t bound) const;
+
+        /// Residue stamping enumeration; see Strategy::Stamp. Falls back to the Felsch solve like solve_hlt().
+        [[nodiscard]] Cosets<> solve_stamp(std::vector<size_t> const &idxs, size_t bound) const;
+
+        /// The complete table of a finished working table, with cosets numbered as Felsch defines them.
+        [[nodiscard]] Cosets<> standardize(Table const &table) const;
+
+        /**
+         * Run the enumeration with coset indexes of type Idx until it completes or reaches the bound, and return
+         * true. Return false if the next coset would not fit in Idx; the caller must promote the table and resume.
+         * The kernel for Rank 0 works for any rank; others are compiled for exactly that rank.
+         */
+        template<typename Idx, size_t Rank>
+        bool enumerate(Cosets<> &cosets, SolverWorkspace::State &state, size_t &idx, size_t bound) const;
+
+        /// Run enumerate() with the kernel compiled for this rank, if there is one.
+        template<typename Idx>
+        bool dispatch(Cosets<> &cosets, SolverWorkspace::State &state, size_t &idx, size_t bound) const;
+
+        friend Solver;
+    };
+
+    /**
+     * @brief A Felsch solve that keeps its state when it stops at the bound, so it can later be extended to a larger
+     * bound. Extending continues exactly where the solve stopped, and gives the same table as a fresh solve with the
+     * larger bound, at the cost of only the new cosets. The relation tables and queues stay allocated until the
+     * solver is destroyed. Solvers do not use the group's cache.
+     */
+    struct Solver {
+        Solver(Group<> const &group, std::vector<size_t> const &idxs, size_t bound = SIZE_MAX);
+
+        /// Solve with <code>workspace</code>, which the solver keeps. Pass a scratch workspace to solve out-of-core.
+        Solver(Group<> const &group, std::vector<size_t> const &idxs, size_t bound, SolverWorkspace workspace);
+
+        Solver(Solver &&) noexcept;
+
+        ~Solver();
+
+        /// Continue the solve until it completes or the order reaches <code>bound</code>.
+        Cosets<> const &extend(size_t bound = SIZE_MAX);
+
+        /// Continue the solve until it completes or stops at one of the limits in <code>options</code>. A solve
+        /// stopped by cancellation, a deadline or the memory budget can be extended again.
+        Cosets<> const &extend(SolveOptions const &options);
+
+        [[nodiscard]] Cosets<> const &cosets() const;
+
+        /// Take the table, leaving the solver unusable.
+        [[nodiscard]] Cosets<> release() &&;
+
+    private:
+        Group<> _group;
+        std::vector<size_t> _idxs;
+        SolverWorkspace _workspace;
+        size_t _idx;
+        Cosets<> _cosets;
     };
 
     template<typename Gen_>
@@ -174,8 +821,8 @@ namespace tc {
         }
 
     private:
-        Cosets(size_t rank, std::vector<Gen> gens)
-            : Cosets<>(rank), _index(gens) {}
+        Cosets(Group<> const &group, std::vector<Gen> gens)
+            : Cosets<>(group), _index(gens) {}
     };
 
     template<typename Gen_>
@@ -213,15 +860,73 @@ namespace tc {
         
         [[nodiscard]] Group sub(std::vector<Gen> const &gens) const {
             std::vector<size_t> idxs(gens.size());
-            std::transform(gens.begin(), gens.end(), idxs.begin(), _index);
+            std::transform(gens.begin(), gens.end(), idxs.begin(), std::cref(_index));
             return Group(Group<>::sub(idxs), gens);
         }
 
+        [[nodiscard]] std::optional<size_t> order(std::vector<Gen> const &gens) const {
+            std::vector<size_t> idxs(gens.size());
+            std::transform(gens.begin(), gens.end(), idxs.begin(), std::cref(_index));
+
+            return Group<>::order(idxs);
+        }
+
+        [[nodiscard]] Growth growth(std::vector<Gen> const &gens) const {
+            std::vector<size_t> idxs(gens.size());
+            std::transform(gens.begin(), gens.end(), idxs.begin(), std::cref(_index));
+
+            return Group<>::growth(idxs);
+        }
+
         [[nodiscard]] Cosets<Gen> solve(std::vector<Gen> const &gens, size_t bound = SIZE_MAX) const {
             std::vector<size_t> idxs(gens.size());
-            std::transform(gens.begin(), gens.end(), idxs.begin(), _index);
+            std::transform(gens.begin(), gens.end(), idxs.begin(), std::cref(_index));
+
+            return Cosets<Gen>(Group<>::solve(idxs, bound), _index._gens);
+        }
+
+        [[nodiscard]] Cosets<Gen> solve(
+            std::vector<Gen> const &gens, size_t bound, SolverWorkspace &workspace
+        ) const {
+            std::vector<size_t> idxs(gens.size());
+            std::transform(gens.begin(), gens.end(), idxs.begin(), std::cref(_index));
+
+            return Cosets<Gen>(Group<>::solve(idxs, bound, workspace), _index._gens);
+        }
+
+        [[nodiscard]] Cosets<Gen> solve(
+            std::vector<Gen> const &gens, size_t bound, unsigned threads, bool serial_order = false
+        ) const {
+            std::vector<size_t> idxs(gens.size());
+            std::transform(gens.begin(), gens.end(), idxs.begin(), std::cref(_index));
+
+            return Cosets<Gen>(Group<>::solve(idxs, bound, threads, serial_order), _index._gens);
+        }
+
+        [[nodiscard]] Cosets<Gen> solve(std::vector<Gen> const &gens, size_t bound, Strategy strategy) const {
+            std::vector<size_t> idxs(gens.size());
+            std::transform(gens.begin(), gens.end(), idxs.begin(), std::cref(_index));
+
+            return Cosets<Gen>(Group<>::solve(idxs, bound, strategy), _index._gens);
+        }
 
-            return Cosets<Gen>(Group<>::solve(idxs, bound), gens);
+        [[nodiscard]] std::vector<Cosets<Gen>> solve_all(
+            std::vector<std::vector<Gen>> const &subsets, size_t bound = SIZE_MAX, unsigned threads = 0
+        ) const {
+            std::vector<std::vector<size_t>> idxs;
+            for (auto const &gens: subsets) {
+                auto &sub_idxs = idxs.emplace_back(gens.size());
+                std::transform(gens.begin(), gens.end(), sub_idxs.begin(), std::cref(_index));
+            }
+
+            auto solved = Group<>::solve_all(idxs, bound, threads);
+
+            std::vector<Cosets<Gen>> res;
+            res.reserve(solved.size());
+            for (size_t k = 0; k < solved.size(); ++k) {
+                res.emplace_back(std::move(solved[k]), _index._gens);
+            }
+            return res;
         }
     };
 }
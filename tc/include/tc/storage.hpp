@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tc {
+    /**
+     * @brief Growable byte buffer for coset tables, kept either on the heap or in a file-backed memory map.
+     *
+     * A mapped buffer lives in an unlinked scratch file, so the kernel can page it out to disk and the file disappears
+     * when the buffer is destroyed. Its address range is reserved up front, so growing it never moves the data; the
+     * file itself is extended in large chunks.
+     *
+     * A buffer may also view part of an existing file. The mapping is private, so processes reading the same file
+     * share its pages, and writes stay local to the process. Such a buffer cannot grow.
+     */
+    class Storage {
+    public:
+        /// Heap storage.
+        Storage();
+
+        /// File-backed storage in a new scratch file under <code>dir</code>.
+        static Storage mapped(std::string const &dir);
+
+        /// Private view of <code>bytes</code> bytes of the file at <code>path</code>, starting at <code>offset</code>.
+        static Storage view(std::string const &path, size_t offset, size_t bytes);
+
+        Storage(Storage const &other);
+
+        Storage(Storage &&other) noexcept;
+
+        Storage &operator=(Storage const &other);
+
+        Storage &operator=(Storage &&other) noexcept;
+
+        ~Storage();
+
+        [[nodiscard]] uint8_t *data();
+
+        [[nodiscard]] uint8_t const *data() const;
+
+        [[nodiscard]] size_t size() const;
+
+        [[nodiscard]] bool is_mapped() const;
+
+        void reserve(size_t bytes);
+
+        /// Grow or shrink to <code>bytes</code>, setting any new bytes to <code>fill</code>.
+        void resize(size_t bytes, uint8_t fill);
+
+        /// Set <code>bytes</code> bytes, all to <code>fill</code>.
+        void assign(size_t bytes, uint8_t fill);
+
+        /// An empty storage: a new scratch file in the same directory for scratch storage, otherwise the heap.
+        [[nodiscard]] Storage fresh() const;
+
+    private:
+        std::vector<uint8_t> _heap;
+
+        std::string _dir;
+        int _fd = -1;
+        void *_base = nullptr;  // start of the mapping
+        size_t _length = 0;     // length of the mapping
+        uint8_t *_map = nullptr;
+        size_t _size = 0;
+        size_t _capacity = 0;  // bytes in the scratch file
+
+        void release();
+    };
+}
@@ -0,0 +1,191 @@
+#include <tc/automaton.hpp>
+
+#include <cmath>
+#include <numbers>
+
+namespace tc {
+    namespace {
+        /// Tolerance for comparing root coordinates, which are sums of cosines.
+        constexpr double EPS = 1e-9;
+
+        bool same(std::vector<double> const &a, std::vector<double> const &b) {
+            for (size_t k = 0; k < a.size(); ++k) {
+                if (std::abs(a[k] - b[k]) > EPS) return false;
+            }
+            return true;
+        }
+    }
+
+    Automaton::Automaton(Group<> const &group)
+        : _rank(group.rank()), _roots(), _width(), _reflect(), _sets(), _next(), _index() {
+        // region Small roots
+        // bilinear form on the simple roots: B(a_i, a_j) = -cos(pi / m), or -1 for free products.
+        std::vector<double> form(_rank * _rank);
+        for (size_t i = 0; i < _rank; ++i) {
+            for (size_t j = 0; j < _rank; ++j) {
+                Mult m = group.get(i, j);
+                if (i == j) form[i * _rank + j] = 1;
+                else if (m == FREE) form[i * _rank + j] = -1;
+                else form[i * _rank + j] = -std::cos(std::numbers::pi / m);
+            }
+        }
+
+        auto pair = [&](std::vector<double> const &root, size_t gen) {
+            double res = 0;
+            for (size_t k = 0; k < _rank; ++k) {
+                res += root[k] * form[k * _rank + gen];
+            }
+            return res;
+        };
+
+        auto find = [](std::vector<std::vector<double>> const &roots, std::vector<double> const &root) {
+            for (size_t idx = 0; idx < roots.size(); ++idx) {
+                if (same(roots[idx], root)) return idx;
+            }
+            return FAIL;
+        };
+
+        // the simple roots come first, so root gen is a_gen.
+        std::vector<std::vector<double>> roots;
+        for (size_t gen = 0; gen < _rank; ++gen) {
+            roots.emplace_back(_rank, 0);
+            roots.back()[gen] = 1;
+        }
+
+        for (size_t idx = 0; idx < roots.size(); ++idx) {
+            for (size_t gen = 0; gen < _rank; ++gen) {
+                double b = pair(roots[idx], gen);
+                if (b <= -1 + EPS || b >= -EPS) continue;
+
+                std::vector<double> image = roots[idx];
+                image[gen] -= 2 * b;
+                if (find(roots, image) == FAIL) roots.push_back(std::move(image));
+            }
+        }
+        // endregion
+
+        _roots = roots.size();
+        _width = (_roots + 63) / 64;
+
+        _reflect.assign(_roots * _rank, FAIL);
+        for (size_t idx = 0; idx < _roots; ++idx) {
+            for (size_t gen = 0; gen < _rank; ++gen) {
+                if (idx == gen) continue;
+
+                std::vector<double> image = roots[idx];
+                image[gen] -= 2 * pair(roots[idx], gen);
+                _reflect[idx * _rank + gen] = find(roots, image);
+            }
+        }
+
+        intern(std::vector<uint64_t>(_width, 0));
+    }
+
+    [[nodiscard]] size_t Automaton::rank() const {
+        return _rank;
+    }
+
+    [[nodiscard]] size_t Automaton::roots() const {
+        return _roots;
+    }
+
+    [[nodiscard]] size_t Automaton::states() const {
+        return _index.size();
+    }
+
+    [[nodiscard]] size_t Automaton::next(size_t state, size_t gen) {
+        size_t &res = _next[state * _rank + gen];
+        if (res != UNKNOWN) return res;
+
+        uint64_t const *set = &_sets[state * _width];
+        auto has = [&](size_t root) { return (set[root / 64] >> (root % 64)) & 1; };
+
+        // a_gen in the state means gen shortens the word, or a word with a smaller letter reaches the same element.
+        if (has(gen)) {
+            return res = FAIL;
+        }
+
+        // the new state is a_gen and the small images under gen of the old roots and of each a_t for t < gen.
+        std::vector<uint64_t> out(_width, 0);
+        auto add = [&](size_t root) {
+            if (root != FAIL) out[root / 64] |= uint64_t(1) << (root % 64);
+        };
+
+        add(gen);
+        for (size_t root = 0; root < _roots; ++root) {
+            if (has(root) || root < gen) {
+                add(_reflect[root * _rank + gen]);
+            }
+        }
+
+        // intern() may move the table, so res is not used past this point.
+        size_t target = intern(out);
+        _next[state * _rank + gen] = target;
+        return target;
+    }
+
+    [[nodiscard]] bool Automaton::accepts(std::vector<size_t> const &word) {
+        size_t state = 0;
+        for (size_t gen: word) {
+            if (gen >= _rank) return false;
+            state = next(state, gen);
+            if (state == FAIL) return false;
+        }
+        return true;
+    }
+
+    size_t Automaton::walk(
+        size_t max_length, size_t count, std::function<void(std::vector<size_t> const &)> const &visit
+    ) {
+        size_t visited = 0;
+
+        std::vector<size_t> word;
+        std::vector<size_t> path;  // path[k] is the state after the first k letters
+        std::vector<size_t> gens;  // gens[k] is the next letter to try after the first k letters
+
+        for (size_t length = 0; length <= max_length && visited < count; ++length) {
+            size_t found = 0;
+            path.assign(1, 0);
+            gens.assign(1, 0);
+
+            while (!gens.empty() && visited < count) {
+                if (word.size() == length || gens.back() == _rank) {
+                    if (word.size() == length && gens.back() == 0) {
+                        visit(word);
+                        visited++;
+                        found++;
+                    }
+
+                    gens.pop_back();
+                    path.pop_back();
+                    if (!word.empty()) word.pop_back();
+                    continue;
+                }
+
+                size_t gen = gens.back()++;
+                size_t state = next(path.back(), gen);
+                if (state == FAIL) continue;
+
+                word.push_back(gen);
+                path.push_back(state);
+                gens.push_back(0);
+            }
+            word.clear();
+
+            // every prefix of a normal form is a normal form, so no longer ones exist.
+            if (found == 0) break;
+        }
+
+        return visited;
+    }
+
+    size_t Automaton::intern(std::vector<uint64_t> const &set) {
+        std::string key(reinterpret_cast<char const *>(set.data()), set.size() * sizeof(uint64_t));
+        auto [it, inserted] = _index.emplace(std::move(key), states());
+        if (inserted) {
+            _sets.insert(_sets.end(), set.begin(), set.end());
+            _next.resize(_next.size() + _rank, UNKNOWN);
+        }
+        return it->second;
+    }
+}
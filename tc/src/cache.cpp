@@ -0,0 +1,318 @@
+#include <tc/cache.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <fmt/core.h>
+
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace tc {
+    namespace {
+        constexpr char const *EXTENSION = ".cosets";
+
+        uint64_t fnv1a(uint64_t hash, void const *data, size_t bytes) {
+            auto const *ptr = static_cast<uint8_t const *>(data);
+            for (size_t idx = 0; idx < bytes; ++idx) {
+                hash ^= ptr[idx];
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        /// The fields of <code>key</code> that the snapshot does not hold: the subgroup generators, their count and
+        /// the bound.
+        std::vector<uint64_t> trailer(CacheKey const &key) {
+            std::vector<uint64_t> res(key.idxs.begin(), key.idxs.end());
+            res.push_back(key.idxs.size());
+            res.push_back(key.bound);
+            return res;
+        }
+
+        /// Append the trailer of <code>key</code> to a snapshot. Cosets<>::map ignores anything past the table.
+        void write_trailer(std::string const &file, CacheKey const &key) {
+            auto fields = trailer(key);
+            std::ofstream out(file, std::ios::binary | std::ios::app);
+            out.write(reinterpret_cast<char const *>(fields.data()), std::streamsize(fields.size() * sizeof(uint64_t)));
+            out.close();
+            if (!out) throw std::runtime_error("tc::DiskCache: cannot write " + file);
+        }
+
+        /// True if <code>file</code> ends with the trailer of <code>key</code>.
+        bool has_trailer(std::string const &file, CacheKey const &key) {
+            auto expected = trailer(key);
+            size_t bytes = expected.size() * sizeof(uint64_t);
+
+            std::ifstream in(file, std::ios::binary | std::ios::ate);
+            if (!in || size_t(in.tellg()) < bytes) return false;
+
+            std::vector<uint64_t> fields(expected.size());
+            in.seekg(-std::streamoff(bytes), std::ios::end);
+            in.read(reinterpret_cast<char *>(fields.data()), std::streamsize(bytes));
+            return in && fields == expected;
+        }
+    }
+
+    CacheKey::CacheKey(Group<> const &group, std::vector<size_t> const &idxs_, size_t bound)
+        : mults(), idxs(), bound(bound) {
+        for (size_t i = 0; i < group.rank(); ++i) {
+            for (size_t j = 0; j < group.rank(); ++j) {
+                mults.push_back(group.get(i, j));
+            }
+        }
+
+        // the solve ignores generators out of range, and repeats or order make no difference.
+        for (size_t g: idxs_) {
+            if (g < group.rank()) idxs.push_back(g);
+        }
+        std::sort(idxs.begin(), idxs.end());
+        idxs.erase(std::unique(idxs.begin(), idxs.end()), idxs.end());
+    }
+
+    [[nodiscard]] uint64_t CacheKey::hash() const {
+        uint64_t hash = 14695981039346656037ull;
+
+        uint64_t sizes[3] = {mults.size(), idxs.size(), bound};
+        hash = fnv1a(hash, sizes, sizeof(sizes));
+        hash = fnv1a(hash, mults.data(), mults.size() * sizeof(Mult));
+        for (uint64_t g: idxs) {
+            hash = fnv1a(hash, &g, sizeof(g));
+        }
+
+        return hash;
+    }
+
+    [[nodiscard]] std::shared_ptr<Cosets<> const> Cache::load_shared(CacheKey const &key) {
+        auto res = load(key);
+        if (!res) return nullptr;
+        return std::make_shared<Cosets<> const>(std::move(*res));
+    }
+
+    void Cache::store_shared(CacheKey const &key, std::shared_ptr<Cosets<> const> const &cosets) {
+        store(key, *cosets);
+    }
+
+    DiskCache::DiskCache(std::string dir, size_t max_bytes)
+        : _dir(std::move(dir)), _max_bytes(max_bytes) {
+        fs::create_directories(_dir);
+    }
+
+    [[nodiscard]] std::string DiskCache::path(CacheKey const &key) const {
+        return fmt::format("{}/{:016x}{}", _dir, key.hash(), EXTENSION);
+    }
+
+    [[nodiscard]] std::optional<Cosets<>> DiskCache::load(CacheKey const &key) {
+        std::string file = path(key);
+
+        // the file may be evicted by another process at any moment, so a failure to map is just a miss.
+        std::optional<Cosets<>> res;
+        try {
+            res.emplace(Cosets<>::map(file));
+        } catch (std::exception const &) {
+            return std::nullopt;
+        }
+
+        // the file name is only a hash, so a different key may have written this file.
+        if (CacheKey(res->group(), key.idxs, key.bound) != key || !has_trailer(file, key)) {
+            return std::nullopt;
+        }
+
+        std::error_code ec;
+        fs::last_write_time(file, fs::file_time_type::clock::now(), ec);
+
+        return res;
+    }
+
+    void DiskCache::store(CacheKey const &key, Cosets<> const &cosets) {
+        static std::atomic<size_t> counter = 0;
+
+        std::string file = path(key);
+        std::string temp = fmt::format("{}.tmp-{}-{}", file, getpid(), counter++);
+
+        // evict() skips temporary files, so one left behind by a failed save or rename would never be removed.
+        try {
+            cosets.save(temp);
+            write_trailer(temp, key);
+            fs::rename(temp, file);
+        } catch (std::exception const &) {
+            std::error_code ec;
+            fs::remove(temp, ec);
+            throw;
+        }
+
+        evict(file);
+    }
+
+    void DiskCache::evict(std::string const &keep) {
+        struct Entry {
+            fs::path path;
+            fs::file_time_type time;
+            size_t size;
+        };
+
+        std::vector<Entry> entries;
+        std::error_code ec;
+        size_t total = fs::file_size(keep, ec);
+        if (ec) total = 0;
+
+        for (auto const &entry: fs::directory_iterator(_dir, ec)) {
+            if (entry.path().extension() != EXTENSION || entry.path() == keep) continue;
+
+            std::error_code entry_ec;
+            auto time = entry.last_write_time(entry_ec);
+            auto size = entry.file_size(entry_ec);
+            if (entry_ec) continue;
+
+            entries.push_back({entry.path(), time, size});
+            total += size;
+        }
+
+        std::sort(entries.begin(), entries.end(), [](auto const &a, auto const &b) { return a.time < b.time; });
+
+        // another process may evict the same files; removing a missing file is harmless.
+        for (auto const &entry: entries) {
+            if (total <= _max_bytes) break;
+            fs::remove(entry.path, ec);
+            total -= entry.size;
+        }
+    }
+
+    MemoryCache::MemoryCache(size_t max_bytes, std::shared_ptr<Cache> next)
+        : _max_bytes(max_bytes), _next(std::move(next)) {}
+
+    [[nodiscard]] std::optional<Cosets<>> MemoryCache::load(CacheKey const &key) {
+        auto res = load_shared(key);
+        if (!res) return std::nullopt;
+        return *res;
+    }
+
+    void MemoryCache::store(CacheKey const &key, Cosets<> const &cosets) {
+        store_shared(key, std::make_shared<Cosets<> const>(cosets));
+    }
+
+    [[nodiscard]] std::shared_ptr<Cosets<> const> MemoryCache::load_shared(CacheKey const &key) {
+        {
+            std::lock_guard lock(_mutex);
+            if (auto res = find(key)) {
+                _hits++;
+                return res;
+            }
+        }
+        _misses++;
+
+        // the next cache may be slow, so it is not consulted under the lock.
+        if (!_next) return nullptr;
+        auto res = _next->load_shared(key);
+        if (res) {
+            std::lock_guard lock(_mutex);
+            insert(key, res);
+        }
+        return res;
+    }
+
+    void MemoryCache::store_shared(CacheKey const &key, std::shared_ptr<Cosets<> const> const &cosets) {
+        {
+            std::lock_guard lock(_mutex);
+            insert(key, cosets);
+        }
+        if (_next) _next->store_shared(key, cosets);
+    }
+
+    [[nodiscard]] size_t MemoryCache::hits() const {
+        return _hits;
+    }
+
+    [[nodiscard]] size_t MemoryCache::misses() const {
+        return _misses;
+    }
+
+    [[nodiscard]] size_t MemoryCache::bytes() const {
+        std::lock_guard lock(_mutex);
+        return _bytes;
+    }
+
+    void MemoryCache::clear() {
+        std::lock_guard lock(_mutex);
+        _entries.clear();
+        _index.clear();
+        _bytes = 0;
+    }
+
+    [[nodiscard]] std::shared_ptr<Cosets<> const> MemoryCache::find(CacheKey const &key) {
+        auto it = _index.find(key.hash());
+        if (it == _index.end() || it->second->key != key) return nullptr;
+
+        _entries.splice(_entries.begin(), _entries, it->second);
+        return it->second->cosets;
+    }
+
+    void MemoryCache::insert(CacheKey const &key, std::shared_ptr<Cosets<> const> const &cosets) {
+        uint64_t hash = key.hash();
+
+        // a different key with the same hash is simply replaced.
+        if (auto it = _index.find(hash); it != _index.end()) {
+            _bytes -= it->second->bytes;
+            _entries.erase(it->second);
+            _index.erase(it);
+        }
+
+        size_t bytes = cosets->order() * cosets->rank() * cosets->width();
+        _entries.push_front({key, cosets, bytes});
+        _index.emplace(hash, _entries.begin());
+        _bytes += bytes;
+
+        // the newest table stays even if it alone exceeds the limit.
+        while (_bytes > _max_bytes && _entries.size() > 1) {
+            auto &last = _entries.back();
+            _bytes -= last.bytes;
+            _index.erase(last.key.hash());
+            _entries.pop_back();
+        }
+    }
+
+    void Group<>::use_cache(std::shared_ptr<Cache> cache) {
+        _cache = std::move(cache);
+    }
+
+    [[nodiscard]] std::shared_ptr<Cache> Group<>::cache() const {
+        return _cache;
+    }
+
+    [[nodiscard]] std::optional<Cosets<>> Group<>::cache_load(std::vector<size_t> const &idxs, size_t bound) const {
+        if (!_cache) return std::nullopt;
+        return _cache->load(CacheKey(*this, idxs, bound));
+    }
+
+    [[nodiscard]] std::shared_ptr<Cosets<> const> Group<>::solve_shared(
+        std::vector<size_t> const &idxs, size_t bound
+    ) const {
+        if (!_cache) {
+            return std::make_shared<Cosets<> const>(solve(idxs, bound));
+        }
+
+        SolverWorkspace workspace;
+        auto known = check_stops(idxs, SolveOptions{bound}, workspace);
+
+        CacheKey key(*this, idxs, bound);
+        if (auto cached = _cache->load_shared(key)) {
+            return cached;
+        }
+
+        auto res = std::make_shared<Cosets<> const>(solve_felsch(idxs, known, SolveOptions{bound}, workspace));
+        if (res->complete()) {
+            _cache->store_shared(key, res);
+        }
+        return res;
+    }
+
+    void Group<>::cache_store(std::vector<size_t> const &idxs, size_t bound, Cosets<> const &cosets) const {
+        if (!_cache || !cosets.complete()) return;
+        _cache->store(CacheKey(*this, idxs, bound), cosets);
+    }
+}
@@ -0,0 +1,290 @@
+#include <tc/core.hpp>
+
+#include <cmath>
+#include <numbers>
+#include <numeric>
+
+namespace tc {
+    namespace {
+        /// Tolerance for the pivots of the Gram matrix, which are sums of products of cosines.
+        constexpr double EPS = 1e-9;
+
+        size_t saturating_mul(size_t a, size_t b) {
+            if (a != 0 && b > SIZE_MAX / a) return SIZE_MAX;
+            return a * b;
+        }
+
+        /// The degrees of a finite irreducible group, or empty if <code>gens</code> do not form one.
+        std::vector<size_t> degrees(Group<> const &group, std::vector<size_t> const &gens, char &family) {
+            size_t n = gens.size();
+            std::vector<size_t> res;
+
+            if (n == 1) {
+                family = 'A';
+                return {2};
+            }
+
+            if (n == 2) {
+                Mult m = group.get(gens[0], gens[1]);
+                if (m == FREE) return {};
+                family = m == 3 ? 'A' : m == 4 ? 'B' : 'I';
+                return {2, m};
+            }
+
+            // larger finite diagrams are trees with labels 3, 4 and 5.
+            std::vector<std::vector<size_t>> adj(n);
+            size_t edges = 0;
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = i + 1; j < n; ++j) {
+                    Mult m = group.get(gens[i], gens[j]);
+                    if (m == 2) continue;
+                    if (m != 3 && m != 4 && m != 5) return {};
+
+                    adj[i].push_back(j);
+                    adj[j].push_back(i);
+                    edges++;
+                }
+            }
+            if (edges != n - 1) return {};
+
+            auto label = [&](size_t i, size_t j) { return group.get(gens[i], gens[j]); };
+
+            size_t branch = n;
+            for (size_t v = 0; v < n; ++v) {
+                if (adj[v].size() > 3) return {};
+                if (adj[v].size() == 3) {
+                    if (branch != n) return {};
+                    branch = v;
+                }
+            }
+
+            if (branch == n) {
+                // a path: read its labels from one end.
+                size_t end = 0;
+                while (adj[end].size() != 1) end++;
+
+                std::vector<Mult> labels;
+                for (size_t prev = n, v = end; labels.size() < n - 1;) {
+                    size_t next = adj[v][0] == prev ? adj[v][1] : adj[v][0];
+                    labels.push_back(label(v, next));
+                    prev = v;
+                    v = next;
+                }
+
+                size_t odd = n - 1;  // position of the one label that is not 3
+                for (size_t k = 0; k < labels.size(); ++k) {
+                    if (labels[k] == 3) continue;
+                    if (odd != n - 1) return {};
+                    odd = k;
+                }
+
+                if (odd == n - 1) {
+                    family = 'A';
+                    for (size_t d = 2; d <= n + 1; ++d) res.push_back(d);
+                    return res;
+                }
+
+                bool at_end = odd == 0 || odd == n - 2;
+                if (labels[odd] == 4 && at_end) {
+                    family = 'B';
+                    for (size_t d = 1; d <= n; ++d) res.push_back(2 * d);
+                    return res;
+                }
+                if (labels[odd] == 4 && n == 4) {
+                    family = 'F';
+                    return {2, 6, 8, 12};
+                }
+                if (labels[odd] == 5 && at_end && n == 3) {
+                    family = 'H';
+                    return {2, 6, 10};
+                }
+                if (labels[odd] == 5 && at_end && n == 4) {
+                    family = 'H';
+                    return {2, 12, 20, 30};
+                }
+                return {};
+            }
+
+            // a tree with one branch point: all labels 3, and the arm lengths pick D or E.
+            std::vector<size_t> arms;
+            for (size_t first: adj[branch]) {
+                if (label(branch, first) != 3) return {};
+
+                size_t length = 1;
+                for (size_t prev = branch, v = first; adj[v].size() == 2; ++length) {
+                    size_t next = adj[v][0] == prev ? adj[v][1] : adj[v][0];
+                    if (label(v, next) != 3) return {};
+                    prev = v;
+                    v = next;
+                }
+                arms.push_back(length);
+            }
+            std::sort(arms.begin(), arms.end());
+
+            if (arms[0] == 1 && arms[1] == 1) {
+                family = 'D';
+                for (size_t d = 1; d < n; ++d) res.push_back(2 * d);
+                res.push_back(n);
+                return res;
+            }
+            if (arms[0] == 1 && arms[1] == 2 && arms[2] <= 4) {
+                family = 'E';
+                switch (arms[2]) {
+                    case 2:
+                        return {2, 5, 6, 8, 9, 12};
+                    case 3:
+                        return {2, 6, 8, 10, 12, 14, 18};
+                    default:
+                        return {2, 8, 12, 14, 18, 20, 24, 30};
+                }
+            }
+            return {};
+        }
+
+        /// Whether an irreducible component that is not finite is affine, from the LDL^T factorization of its Gram
+        /// matrix.
+        Kind signature(Group<> const &group, std::vector<size_t> const &gens) {
+            size_t n = gens.size();
+
+            std::vector<double> form(n * n);
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    Mult m = group.get(gens[i], gens[j]);
+                    if (i == j) form[i * n + j] = 1;
+                    else if (m == FREE) form[i * n + j] = -1;
+                    else form[i * n + j] = -std::cos(std::numbers::pi / m);
+                }
+            }
+
+            // every proper subdiagram of an affine diagram is finite, so all pivots but the last are positive and the
+            // last is zero. Anything else is indefinite.
+            std::vector<double> lower(n * n, 0), pivots(n, 0);
+            for (size_t k = 0; k < n; ++k) {
+                double pivot = form[k * n + k];
+                for (size_t j = 0; j < k; ++j) {
+                    pivot -= lower[k * n + j] * lower[k * n + j] * pivots[j];
+                }
+                pivots[k] = pivot;
+
+                if (k + 1 == n) {
+                    return std::abs(pivot) <= EPS ? Kind::Affine : Kind::Other;
+                }
+                if (pivot <= EPS) {
+                    return Kind::Other;
+                }
+
+                for (size_t i = k + 1; i < n; ++i) {
+                    double sum = form[i * n + k];
+                    for (size_t j = 0; j < k; ++j) {
+                        sum -= lower[i * n + j] * lower[k * n + j] * pivots[j];
+                    }
+                    lower[i * n + k] = sum / pivot;
+                }
+            }
+            return Kind::Other;
+        }
+    }
+
+    [[nodiscard]] std::optional<size_t> Component::order() const {
+        if (kind != Kind::Finite) return std::nullopt;
+
+        size_t res = 1;
+        for (size_t d: degrees) {
+            res = saturating_mul(res, d);
+        }
+        return res;
+    }
+
+    [[nodiscard]] std::string Component::name() const {
+        switch (kind) {
+            case Kind::Affine:
+                return "affine";
+            case Kind::Other:
+                return "other";
+            case Kind::Finite:
+            default:
+                break;
+        }
+
+        if (family == 'I') {
+            return "I2(" + std::to_string(degrees[1]) + ")";
+        }
+        return family + std::to_string(gens.size());
+    }
+
+    [[nodiscard]] std::vector<Component> Group<>::classify() const {
+        std::vector<Component> res;
+
+        std::vector<bool> seen(rank(), false);
+        for (size_t root = 0; root < rank(); ++root) {
+            if (seen[root]) continue;
+
+            Component &component = res.emplace_back();
+            auto &gens = component.gens;
+            gens.push_back(root);
+            seen[root] = true;
+            for (size_t k = 0; k < gens.size(); ++k) {
+                for (size_t other = 0; other < rank(); ++other) {
+                    if (!seen[other] && get(gens[k], other) != 2) {
+                        gens.push_back(other);
+                        seen[other] = true;
+                    }
+                }
+            }
+            std::sort(gens.begin(), gens.end());
+
+            component.degrees = degrees(*this, gens, component.family);
+            component.kind = component.degrees.empty() ? signature(*this, gens) : Kind::Finite;
+        }
+
+        return res;
+    }
+
+    [[nodiscard]] std::optional<size_t> Group<>::order(std::vector<size_t> const &idxs) const {
+        return order(idxs, classify());
+    }
+
+    [[nodiscard]] std::optional<size_t> Group<>::order(
+        std::vector<size_t> const &idxs, std::vector<Component> const &components
+    ) const {
+        std::vector<bool> fixed(rank(), false);
+        for (size_t g: idxs) {
+            if (g < rank())
+                fixed[g] = true;
+        }
+
+        // the index is the product of the degrees of the group over those of the subgroup. Each denominator is
+        // cancelled against the numerators by common factors, so the result is exact whenever it fits.
+        std::vector<size_t> numer, denom;
+        for (auto const &component: components) {
+            std::vector<size_t> sub_idxs;
+            for (size_t g: component.gens) {
+                if (fixed[g]) sub_idxs.push_back(g);
+            }
+            if (sub_idxs.size() == component.gens.size()) continue;
+            if (component.kind != Kind::Finite) return std::nullopt;
+
+            numer.insert(numer.end(), component.degrees.begin(), component.degrees.end());
+            for (auto const &part: sub(sub_idxs).classify()) {
+                denom.insert(denom.end(), part.degrees.begin(), part.degrees.end());
+            }
+        }
+
+        for (size_t d: denom) {
+            for (size_t left = 0; d > 1 && left != d;) {
+                left = d;
+                for (size_t &n: numer) {
+                    size_t common = std::gcd(d, n);
+                    d /= common;
+                    n /= common;
+                }
+            }
+        }
+
+        size_t res = 1;
+        for (size_t n: numer) {
+            res = saturating_mul(res, n);
+        }
+        return res;
+    }
+}
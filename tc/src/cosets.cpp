@@ -1,8 +1,153 @@
 #include <tc/core.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
 namespace tc {
-    Cosets<>::Cosets(size_t rank)
-        : _rank(rank), _order(0), _complete(false), _data() {}
+    namespace {
+        /**
+         * Snapshot header. It is followed by the Coxeter matrix, <code>rank * rank</code> values of Mult, and then by
+         * the table at <code>data_offset</code>, which is page-aligned. Fields are in native byte order;
+         * <code>endian</code> detects a file written on a machine with a different one.
+         */
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t endian;
+            uint64_t rank;
+            uint64_t order;
+            uint64_t complete;
+            uint64_t width;
+            uint64_t data_offset;
+        };
+
+        constexpr char MAGIC[8] = {'t', 'c', 'c', 'o', 's', 'e', 't', 's'};
+        constexpr uint32_t VERSION = 1;
+        constexpr uint32_t ENDIAN = 0x01020304;
+        constexpr size_t ALIGN = 4096;
+
+        template<typename Idx>
+        size_t load(uint8_t const *data, size_t idx) {
+            Idx val = reinterpret_cast<Idx const *>(data)[idx];
+            return val == std::numeric_limits<Idx>::max() ? Cosets<>::UNSET : val;
+        }
+
+        template<typename Idx>
+        void store(uint8_t *data, size_t idx, size_t val) {
+            // UNSET truncates to the maximum value of Idx, which is UNSET at that width.
+            reinterpret_cast<Idx *>(data)[idx] = static_cast<Idx>(val);
+        }
+
+        size_t load(size_t width, uint8_t const *data, size_t idx) {
+            switch (width) {
+                case sizeof(uint16_t):
+                    return load<uint16_t>(data, idx);
+                case sizeof(uint32_t):
+                    return load<uint32_t>(data, idx);
+                default:
+                    return load<uint64_t>(data, idx);
+            }
+        }
+
+        void store(size_t width, uint8_t *data, size_t idx, size_t val) {
+            switch (width) {
+                case sizeof(uint16_t):
+                    return store<uint16_t>(data, idx, val);
+                case sizeof(uint32_t):
+                    return store<uint32_t>(data, idx, val);
+                default:
+                    return store<uint64_t>(data, idx, val);
+            }
+        }
+    }
+
+    Cosets<>::Cosets(Group<> const &group)
+        : _rank(group.rank()), _order(0), _complete(false), _stop(StopReason::Bound), _width(sizeof(uint16_t)),
+          _mults(), _data(), _depth(), _path() {
+        _mults.reserve(rank() * rank());
+        for (size_t i = 0; i < rank(); ++i) {
+            for (size_t j = 0; j < rank(); ++j) {
+                _mults.push_back(group.get(i, j));
+            }
+        }
+    }
+
+    Cosets<> Cosets<>::map(std::string const &path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("tc::Cosets: cannot open " + path);
+
+        Header header{};
+        in.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!in || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error("tc::Cosets: not a coset table: " + path);
+        }
+        if (header.version != VERSION || header.endian != ENDIAN) {
+            throw std::runtime_error("tc::Cosets: unsupported version or byte order: " + path);
+        }
+        if (header.width != sizeof(uint16_t) && header.width != sizeof(uint32_t) && header.width != sizeof(uint64_t)) {
+            throw std::runtime_error("tc::Cosets: bad entry width: " + path);
+        }
+
+        Group<> group(header.rank);
+        std::vector<Mult> mults(header.rank * header.rank);
+        in.read(reinterpret_cast<char *>(mults.data()), std::streamsize(mults.size() * sizeof(Mult)));
+        if (!in) throw std::runtime_error("tc::Cosets: truncated header: " + path);
+        for (size_t i = 0; i < header.rank; ++i) {
+            for (size_t j = 0; j < header.rank; ++j) {
+                group.set(i, j, mults[i * header.rank + j]);
+            }
+        }
+
+        size_t bytes = header.order * header.rank * header.width;
+        in.seekg(0, std::ios::end);
+        if (size_t(in.tellg()) < header.data_offset + bytes) {
+            throw std::runtime_error("tc::Cosets: truncated table: " + path);
+        }
+
+        Cosets<> res(group);
+        res._order = header.order;
+        res._complete = header.complete != 0;
+        res._width = header.width;
+        res._data = Storage::view(path, header.data_offset, bytes);
+        return res;
+    }
+
+    void Cosets<>::save(std::string const &path) const {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.endian = ENDIAN;
+        header.rank = rank();
+        header.order = order();
+        header.complete = complete();
+        header.width = width();
+
+        size_t head = sizeof(header) + _mults.size() * sizeof(Mult);
+        header.data_offset = (head + ALIGN - 1) / ALIGN * ALIGN;
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        out.write(reinterpret_cast<char const *>(_mults.data()), std::streamsize(_mults.size() * sizeof(Mult)));
+
+        std::vector<char> padding(header.data_offset - head, 0);
+        out.write(padding.data(), std::streamsize(padding.size()));
+        out.write(reinterpret_cast<char const *>(_data.data()), std::streamsize(_data.size()));
+
+        out.close();
+        if (!out) throw std::runtime_error("tc::Cosets: cannot write " + path);
+    }
+
+    [[nodiscard]] Group<> Cosets<>::group() const {
+        Group<> res(rank());
+        for (size_t i = 0; i < rank(); ++i) {
+            for (size_t j = i + 1; j < rank(); ++j) {
+                res.set(i, j, _mults[i * rank() + j]);
+            }
+        }
+        return res;
+    }
 
     void Cosets<>::set(size_t coset, size_t gen, size_t target) {
         set(coset * rank() + gen, target);
@@ -28,28 +173,140 @@ namespace tc {
         return _complete;
     }
 
+    [[nodiscard]] StopReason Cosets<>::stop_reason() const {
+        return _complete ? StopReason::Complete : _stop;
+    }
+
+#ifdef TC_STATS
+    [[nodiscard]] SolveStats const &Cosets<>::stats() const {
+        return _stats;
+    }
+#endif
+
     [[nodiscard]] size_t Cosets<>::size() const {
-        return _data.size();
+        return _data.size() / _width;
+    }
+
+    [[nodiscard]] bool Cosets<>::has_depth() const {
+        return !_depth.empty();
+    }
+
+    [[nodiscard]] size_t Cosets<>::depth(size_t coset) const {
+        if (_depth.empty()) {
+            throw std::logic_error("tc::Cosets::depth: depths were not recorded; see SolveOptions::depth");
+        }
+        return load(_width, _depth.data(), coset);
+    }
+
+    [[nodiscard]] bool Cosets<>::has_path() const {
+        return _path.order() != 0;
+    }
+
+    [[nodiscard]] Path<> const &Cosets<>::path() const {
+        if (!has_path()) {
+            throw std::logic_error("tc::Cosets::path: the path was not recorded; see SolveOptions::path");
+        }
+        return _path;
+    }
+
+    [[nodiscard]] size_t Cosets<>::width() const {
+        return _width;
     }
 
     void Cosets<>::add_row() {
-        _data.resize(_data.size() + rank(), UNSET);
+        _data.resize(_data.size() + rank() * _width, 0xFF);
         _order++;
     }
 
+    void Cosets<>::reserve(size_t bytes) {
+        _data.reserve(bytes);
+    }
+
+    void Cosets<>::record_depth() {
+        // unreached cosets start at UNSET, which stores as the maximum value at any width.
+        _depth.assign(order() * _width, 0xFF);
+        if (order() == 0) return;
+
+        store(_width, _depth.data(), 0, 0);
+        for (size_t coset = 1; coset < order(); ++coset) {
+            size_t depth = UNSET;
+            for (size_t gen = 0; gen < rank(); ++gen) {
+                size_t other = get(coset, gen);
+                if (other >= coset) continue;  // also skips unknown products
+
+                depth = std::min(depth, load(_width, _depth.data(), other) + 1);
+            }
+            store(_width, _depth.data(), coset, depth);
+        }
+    }
+
+    void Cosets<>::record_path() {
+        _path = Path<>();
+        if (order() == 0) return;
+
+        // Felsch defines each coset from the first unknown product, so from its smallest neighbour and generator.
+        _path.root();
+        for (size_t coset = 1; coset < order(); ++coset) {
+            size_t parent = UNSET, via = 0;
+            for (size_t gen = 0; gen < rank(); ++gen) {
+                size_t other = get(coset, gen);
+                if (other < parent) {
+                    parent = other;
+                    via = gen;
+                }
+            }
+            _path.add(parent, via);
+        }
+    }
+
+    void Cosets<>::resize(size_t order) {
+        if (order <= std::numeric_limits<uint16_t>::max()) {
+            _width = sizeof(uint16_t);
+        } else if (order <= std::numeric_limits<uint32_t>::max()) {
+            _width = sizeof(uint32_t);
+        } else {
+            _width = sizeof(uint64_t);
+        }
+
+        _data.assign(order * rank() * _width, 0xFF);
+        _order = order;
+    }
+
+    void Cosets<>::promote(size_t width, size_t bytes) {
+        Storage data = _data.fresh();
+        data.reserve(std::max(bytes, size() * width));
+        data.resize(size() * width, 0);
+
+        for (size_t idx = 0; idx < size(); ++idx) {
+            store(width, data.data(), idx, get(idx));
+        }
+
+        _data = std::move(data);
+
+        if (!_depth.empty()) {
+            std::vector<uint8_t> depth(order() * width);
+            for (size_t coset = 0; coset < order(); ++coset) {
+                store(width, depth.data(), coset, load(_width, _depth.data(), coset));
+            }
+            _depth = std::move(depth);
+        }
+
+        _width = width;
+    }
+
     void Cosets<>::set(size_t idx, size_t target) {
         size_t coset = idx / rank();
         size_t gen = idx % rank();
-        _data[idx] = target;
-        _data[target * rank() + gen] = coset;
+        store(_width, _data.data(), idx, target);
+        store(_width, _data.data(), target * rank() + gen, coset);
     }
 
     [[nodiscard]] size_t Cosets<>::get(size_t idx) const {
-        return _data[idx];
+        return load(_width, _data.data(), idx);
     }
 
     [[nodiscard]] bool Cosets<>::isset(size_t idx) const {
         return get(idx) != UNSET;
     }
 
-}
\ No newline at end of file
+}
@@ -3,7 +3,7 @@
 #include <cassert>
 
 namespace tc {
-    Group<>::Group(size_t rank) : _rank(rank), _mults(_rank * _rank, 2) {
+    Group<>::Group(size_t rank) : _rank(rank), _mults(_rank * _rank, 2), _cache() {
         for (int idx = 0; idx < rank; ++idx) {
             set(idx, idx, 1);
         }
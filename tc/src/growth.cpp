@@ -0,0 +1,269 @@
+#include <tc/core.hpp>
+
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+namespace tc {
+    namespace {
+        /// Integer polynomial, constant term first.
+        using Poly = std::vector<int64_t>;
+
+        Poly multiply(Poly const &a, Poly const &b) {
+            Poly res(a.size() + b.size() - 1, 0);
+            for (size_t i = 0; i < a.size(); ++i) {
+                if (a[i] == 0) continue;
+                for (size_t j = 0; j < b.size(); ++j) {
+                    res[i + j] += a[i] * b[j];
+                }
+            }
+            return res;
+        }
+
+        /// a / b if b divides a, for a monic b.
+        std::optional<Poly> divide(Poly a, Poly const &b) {
+            while (a.size() > 1 && a.back() == 0) a.pop_back();
+            if (a.size() < b.size()) return std::nullopt;
+
+            Poly res(a.size() - b.size() + 1, 0);
+            for (size_t k = res.size(); k-- > 0;) {
+                int64_t c = a[k + b.size() - 1];
+                res[k] = c;
+                if (c == 0) continue;
+                for (size_t j = 0; j < b.size(); ++j) {
+                    a[k + j] -= c * b[j];
+                }
+            }
+
+            for (size_t j = 0; j + 1 < b.size(); ++j) {
+                if (a[j] != 0) return std::nullopt;
+            }
+            return res;
+        }
+
+        /// a * (t - 1) / (t^d - 1), which is a / [d] if [d] = 1 + ... + t^(d-1) divides a.
+        Poly divide_span(Poly const &a, size_t d) {
+            Poly prod(a.size() + 1, 0);
+            for (size_t k = 0; k < a.size(); ++k) {
+                prod[k + 1] += a[k];
+                prod[k] -= a[k];
+            }
+
+            Poly res(prod.size() - d, 0);
+            for (size_t k = res.size(); k-- > 0;) {
+                res[k] = prod[k + d];
+                prod[k] += res[k];
+            }
+            return res;
+        }
+
+        /// t^d - 1
+        Poly cycle(size_t d) {
+            Poly res(d + 1, 0);
+            res[0] = -1;
+            res[d] = 1;
+            return res;
+        }
+
+        int mobius(size_t n) {
+            int res = 1;
+            for (size_t p = 2; p * p <= n; ++p) {
+                if (n % p) continue;
+                n /= p;
+                if (n % p == 0) return 0;
+                res = -res;
+            }
+            return n > 1 ? -res : res;
+        }
+
+        /// Cyclotomic polynomials, each built once from <code>prod over d | n of (t^d - 1)^mu(n/d)</code>.
+        struct Cyclotomic {
+            std::map<size_t, Poly> memo;
+
+            Poly const &operator()(size_t n) {
+                auto it = memo.find(n);
+                if (it != memo.end()) return it->second;
+
+                Poly res = {1};
+                std::vector<size_t> below;
+                for (size_t d = 1; d <= n; ++d) {
+                    if (n % d) continue;
+                    int mu = mobius(n / d);
+                    if (mu > 0) res = multiply(res, cycle(d));
+                    if (mu < 0) below.push_back(d);
+                }
+                for (size_t d: below) {
+                    res = *divide(res, cycle(d));
+                }
+                return memo.emplace(n, std::move(res)).first->second;
+            }
+        };
+
+        struct Fraction {
+            Poly numer;
+            Poly denom;
+            std::set<size_t> cyclotomic;  // n for every cyclotomic factor that may be common to both
+        };
+
+        /// Cancel the cyclotomic factors common to the numerator and the denominator.
+        void reduce(Fraction &fraction, Cyclotomic &phi) {
+            for (size_t n: fraction.cyclotomic) {
+                while (true) {
+                    auto numer = divide(fraction.numer, phi(n));
+                    if (!numer) break;
+                    auto denom = divide(fraction.denom, phi(n));
+                    if (!denom) break;
+
+                    fraction.numer = std::move(*numer);
+                    fraction.denom = std::move(*denom);
+                }
+            }
+        }
+
+        /**
+         * W(t) by Steinberg's formula. Each finite W_T has <code>W_T(t) = prod over degrees d of [d]</code>, where
+         * <code>[d] = 1 + ... + t^(d-1)</code> is the product of the cyclotomic polynomials of the divisors of d other
+         * than 1. Over the least common multiple D of the W_T, <code>1 / W(t) = Q / D</code>, so W(t) is D / Q.
+         */
+        Fraction poincare(Group<> const &group, Cyclotomic &phi) {
+            struct Term {
+                bool odd;
+                size_t length;
+                std::vector<size_t> degrees;
+            };
+            std::vector<Term> terms;
+
+            // a subset of an infinite subset is never needed, so each finite subset is only extended.
+            std::vector<size_t> subset;
+            auto add = [&](Term &term) {
+                for (auto const &component: group.sub(subset).classify()) {
+                    if (component.kind != Kind::Finite) return false;
+                    for (size_t d: component.degrees) {
+                        term.length += d - 1;
+                        term.degrees.push_back(d);
+                    }
+                }
+                return true;
+            };
+
+            std::function<void(size_t)> visit = [&](size_t next) {
+                for (size_t gen = next; gen < group.rank(); ++gen) {
+                    subset.push_back(gen);
+                    Term term{subset.size() % 2 == 1, 0, {}};
+                    if (add(term)) {
+                        terms.push_back(std::move(term));
+                        visit(gen + 1);
+                    }
+                    subset.pop_back();
+                }
+            };
+            terms.push_back({false, 0, {}});
+            visit(0);
+
+            std::map<size_t, size_t> common;
+            for (auto const &term: terms) {
+                std::map<size_t, size_t> powers;
+                for (size_t d: term.degrees) {
+                    for (size_t n = 2; n <= d; ++n) {
+                        if (d % n == 0) powers[n]++;
+                    }
+                }
+                for (auto const &[n, power]: powers) {
+                    common[n] = std::max(common[n], power);
+                }
+            }
+
+            Fraction res{{1}, {0}, {1}};
+            for (auto const &[n, power]: common) {
+                for (size_t k = 0; k < power; ++k) {
+                    res.numer = multiply(res.numer, phi(n));
+                }
+                res.cyclotomic.insert(n);
+            }
+
+            // each term is +-t^N_T D / W_T(t).
+            for (auto const &term: terms) {
+                Poly part = res.numer;
+                for (size_t d: term.degrees) {
+                    part = divide_span(part, d);
+                }
+
+                if (res.denom.size() < part.size() + term.length) res.denom.resize(part.size() + term.length, 0);
+                for (size_t k = 0; k < part.size(); ++k) {
+                    res.denom[k + term.length] += term.odd ? -part[k] : part[k];
+                }
+            }
+            while (res.denom.size() > 1 && res.denom.back() == 0) res.denom.pop_back();
+
+            reduce(res, phi);
+            return res;
+        }
+
+        int64_t checked_mul(int64_t a, int64_t b) {
+            if (a != 0 && b != 0 && std::abs(a) > std::numeric_limits<int64_t>::max() / std::abs(b)) {
+                throw std::overflow_error("tc::Growth::expand: coefficients do not fit in 64 bits");
+            }
+            return a * b;
+        }
+
+        int64_t checked_sub(int64_t a, int64_t b) {
+            if ((b < 0 && a > std::numeric_limits<int64_t>::max() + b)
+                || (b > 0 && a < std::numeric_limits<int64_t>::min() + b)) {
+                throw std::overflow_error("tc::Growth::expand: coefficients do not fit in 64 bits");
+            }
+            return a - b;
+        }
+    }
+
+    [[nodiscard]] std::vector<size_t> Growth::expand(size_t count) const {
+        // denom[0] is 1, so each coefficient follows from the ones before it.
+        std::vector<int64_t> coeffs;
+        coeffs.reserve(count);
+        for (size_t k = 0; k < count; ++k) {
+            int64_t c = k < numer.size() ? numer[k] : 0;
+            for (size_t j = 1; j < denom.size() && j <= k; ++j) {
+                c = checked_sub(c, checked_mul(denom[j], coeffs[k - j]));
+            }
+            coeffs.push_back(c);
+        }
+        return {coeffs.begin(), coeffs.end()};
+    }
+
+    [[nodiscard]] Growth Group<>::growth(std::vector<size_t> const &idxs) const {
+        std::vector<bool> fixed(rank(), false);
+        for (size_t g: idxs) {
+            if (g < rank())
+                fixed[g] = true;
+        }
+
+        Cyclotomic phi;
+        Growth res{{1}, {1}};
+        for (auto const &component: classify()) {
+            std::vector<size_t> sub_idxs;
+            for (size_t g: component.gens) {
+                if (fixed[g]) sub_idxs.push_back(g);
+            }
+            if (sub_idxs.size() == component.gens.size()) continue;
+
+            Fraction fraction = poincare(sub(component.gens), phi);
+            if (!sub_idxs.empty()) {
+                Fraction inner = poincare(sub(sub_idxs), phi);
+                fraction.numer = multiply(fraction.numer, inner.denom);
+                fraction.denom = multiply(fraction.denom, inner.numer);
+                fraction.cyclotomic.insert(inner.cyclotomic.begin(), inner.cyclotomic.end());
+                reduce(fraction, phi);
+            }
+
+            res.numer = multiply(res.numer, fraction.numer);
+            res.denom = multiply(res.denom, fraction.denom);
+        }
+
+        // cancelling t - 1 may leave both signs flipped.
+        if (res.denom[0] < 0) {
+            for (auto &c: res.numer) c = -c;
+            for (auto &c: res.denom) c = -c;
+        }
+        return res;
+    }
+}
@@ -0,0 +1,117 @@
+#include <tc/core.hpp>
+
+#include "table.hpp"
+
+namespace tc {
+    namespace {
+        /// Lookahead runs once the working table holds this many cosets, live or dead. The limit doubles whenever
+        /// lookahead frees less than half of the table, so memory stays within a small factor of the live cosets.
+        constexpr size_t LOOKAHEAD_MIN = 1 << 12;
+    }
+
+    [[nodiscard]] Cosets<> Group<>::solve(std::vector<size_t> const &idxs, size_t bound, Strategy strategy) const {
+        switch (strategy) {
+            case Strategy::HLT:
+                return solve_hlt(idxs, bound);
+            case Strategy::Stamp:
+                return solve_stamp(idxs, bound);
+            case Strategy::Felsch:
+            default:
+                return solve(idxs, bound);
+        }
+    }
+
+    [[nodiscard]] Cosets<> Group<>::solve_hlt(std::vector<size_t> const &idxs, size_t bound) const {
+        if (rank() == 0 || bound <= 1) {
+            return solve(idxs, bound);
+        }
+
+        check_stops(idxs, SolveOptions{bound});
+
+        if (auto cached = cache_load(idxs, bound)) {
+            return std::move(*cached);
+        }
+
+        std::vector<Rel> rels;
+        for (size_t i = 0; i < rank(); ++i) {
+            for (size_t j = i + 1; j < rank(); ++j) {
+                if (get(i, j) != FREE) {
+                    rels.emplace_back(i, j, get(i, j));
+                }
+            }
+        }
+
+        Table table(rank());
+        for (size_t g: idxs) {
+            if (g < rank())
+                table.set(0, g, 0);
+        }
+
+        size_t limit = LOOKAHEAD_MIN;
+
+        for (size_t coset = 0; coset < table.size(); ++coset) {
+            if (!table.alive(coset)) continue;
+
+            for (const auto &[i, j, m]: rels) {
+                table.scan(coset, i, j, m, true);
+                if (!table.alive(coset)) break;
+            }
+
+            for (size_t gen = 0; gen < rank() && table.alive(coset); ++gen) {
+                if (table.get(coset, gen) == Table::UNSET) {
+                    table.define(coset, gen);
+                }
+            }
+
+            if (table.size() >= limit) {
+                for (size_t ahead = 0; ahead < table.size(); ++ahead) {
+                    for (const auto &[i, j, m]: rels) {
+                        if (!table.alive(ahead)) break;
+                        table.scan(ahead, i, j, m, false);
+                    }
+                }
+
+                coset = table.compact(coset + 1) - 1;
+
+                if (table.size() * 2 > limit) {
+                    limit *= 2;
+                }
+            }
+
+            if (table.live >= bound) {
+                return solve(idxs, bound);
+            }
+        }
+
+        Cosets<> cosets = standardize(table);
+        cache_store(idxs, bound, cosets);
+        return cosets;
+    }
+
+    [[nodiscard]] Cosets<> Group<>::standardize(Table const &table) const {
+        // Number the cosets breadth-first, visiting generators in index order; this is the order Felsch defines them.
+        std::vector<size_t> queue = {0};
+        std::vector<size_t> label(table.size(), Table::UNSET);
+        label[0] = 0;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            for (size_t gen = 0; gen < rank(); ++gen) {
+                size_t target = table.get(queue[head], gen);
+                if (label[target] != Table::UNSET) continue;
+
+                label[target] = queue.size();
+                queue.push_back(target);
+            }
+        }
+
+        Cosets<> cosets(*this);
+        cosets.resize(queue.size());
+        cosets._complete = true;
+        for (size_t coset = 0; coset < queue.size(); ++coset) {
+            for (size_t gen = 0; gen < rank(); ++gen) {
+                cosets.set(coset * rank() + gen, label[table.get(queue[coset], gen)]);
+            }
+        }
+
+        return cosets;
+    }
+}
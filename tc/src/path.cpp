@@ -0,0 +1,99 @@
+#include <tc/core.hpp>
+
+#include <algorithm>
+#include <barrier>
+#include <thread>
+
+namespace tc {
+    namespace {
+        /// Levels with fewer cosets than this are done by one thread.
+        constexpr size_t PARALLEL_MIN = 1 << 12;
+    }
+
+    [[nodiscard]] size_t Path<>::order() const {
+        return _parents.size();
+    }
+
+    [[nodiscard]] size_t Path<>::parent(size_t coset) const {
+        return _parents[coset];
+    }
+
+    [[nodiscard]] size_t Path<>::gen(size_t coset) const {
+        return _gens[coset];
+    }
+
+    [[nodiscard]] size_t Path<>::levels() const {
+        return _levels.size();
+    }
+
+    [[nodiscard]] size_t Path<>::level(size_t level) const {
+        return level < _levels.size() ? _levels[level] : order();
+    }
+
+    void Path<>::root() {
+        _parents.assign(1, Cosets<>::UNSET);
+        _gens.assign(1, 0);
+        _levels.assign(1, 0);
+    }
+
+    void Path<>::add(size_t parent, size_t gen) {
+        // a child of the deepest level starts the next one.
+        if (parent >= _levels.back()) {
+            _levels.push_back(order());
+        }
+        _parents.push_back(parent);
+        _gens.push_back(gen);
+    }
+
+    void Path<>::each_level(unsigned threads, std::function<void(size_t, size_t)> const &op) const {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // a run of small levels is one serial segment; parents come first, so it can be done in index order.
+        struct Segment {
+            size_t begin, end;
+            bool parallel;
+        };
+        std::vector<Segment> segments;
+        for (size_t lvl = 1; lvl < levels(); ++lvl) {
+            size_t begin = level(lvl), end = level(lvl + 1);
+            bool parallel = threads > 1 && end - begin >= PARALLEL_MIN;
+
+            if (!parallel && !segments.empty() && !segments.back().parallel) {
+                segments.back().end = end;
+            } else {
+                segments.push_back({begin, end, parallel});
+            }
+        }
+
+        if (std::none_of(segments.begin(), segments.end(), [](auto const &segment) { return segment.parallel; })) {
+            for (auto const &[begin, end, parallel]: segments) {
+                op(begin, end);
+            }
+            return;
+        }
+
+        std::barrier sync(threads);
+        auto work = [&](size_t t) {
+            for (auto const &[begin, end, parallel]: segments) {
+                if (parallel) {
+                    size_t count = end - begin;
+                    op(begin + count * t / threads, begin + count * (t + 1) / threads);
+                } else if (t == 0) {
+                    op(begin, end);
+                }
+                sync.arrive_and_wait();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < threads; ++t) {
+            workers.emplace_back(work, t);
+        }
+        work(0);
+        for (auto &worker: workers) {
+            worker.join();
+        }
+    }
+}
@@ -1,10 +1,27 @@
 #include <algorithm>
-#include <queue>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include <tc/core.hpp>
 
+// Statements wrapped in TC_STAT update Cosets<>::stats(); they are removed unless tc is built with TC_STATS.
+#ifdef TC_STATS
+#define TC_STAT(...) __VA_ARGS__
+#else
+#define TC_STAT(...)
+#endif
+
 namespace tc {
     /**
      * Each coset is associated a row in each table.
@@ -13,33 +30,449 @@ namespace tc {
     struct Row {
         bool free: 1;
         bool idem: 1;
-        unsigned int gnr: 14;  // progress through the loop
-        unsigned int lst_idx: 32;  // the coset that would complete the loop
+        uint16_t gnr: 14;  // progress through the loop
+        uint16_t lst_hi;  // the coset that would complete the loop; 48 bits, split so each half is aligned
+        uint32_t lst_lo;
+
+        Row() : free(true), idem(false), gnr(0), lst_hi(0), lst_lo(0) {}
+
+        [[nodiscard]] size_t lst_idx() const {
+            return size_t(lst_hi) << 32 | lst_lo;
+        }
 
-        Row() : free(true), idem(false), gnr(0), lst_idx(0) {}
+        void lst_idx(size_t idx) {
+            lst_hi = static_cast<uint16_t>(idx >> 32);
+            lst_lo = static_cast<uint32_t>(idx);
+        }
     };
 
-    struct Tables {
-        std::vector<Group<>::Rel> rels;
-        std::vector<std::vector<Row>> rows;
+    static_assert(sizeof(Row) == 8);
 
-        explicit Tables(std::vector<Group<>::Rel> rels)
-            : rels(std::move(rels)), rows() {
+    /**
+     * Rows for all relations are kept in one arena indexed by <code>coset * stride + table_idx</code>. The stride is
+     * the number of tables rounded up to a power of two, so the rows of a coset are found by a shift and never
+     * straddle two chunks. The arena is split into fixed-size chunks, so adding a coset is usually free and growing
+     * never copies existing rows.
+     *
+     * Once the scan has passed a coset its rows are never read again, so chunks behind the scan are released to a
+     * spare list and reused for new cosets. Only the rows between the scan and the newest coset stay live.
+     *
+     * Chunks come from the heap, or are carved from <code>pool</code> if it is mapped to a scratch file.
+     */
+    struct Tables {
+        static constexpr size_t CHUNK_BITS = 12;  // chunks grow past this only to hold the rows of one coset
+
+        size_t tables;
+        size_t shift;       // log2 of the stride
+        size_t chunk_bits;
+        std::vector<Row *> chunks;
+        std::vector<Row *> spare;
+        std::vector<std::unique_ptr<Row[]>> owned;
+        Storage pool;
+        size_t allocated;  // bytes of chunks from the heap
+        size_t count;
+        size_t begin;  // chunks before this one have been released
+
+        Tables()
+            : tables(0), shift(0), chunk_bits(CHUNK_BITS), chunks(), spare(), owned(), pool(), allocated(0),
+              count(0), begin(0) {
         }
 
         [[nodiscard]] size_t size() const {
-            return rels.size();
+            return tables;
+        }
+
+        /// Forget all rows, but keep the chunks for reuse.
+        void clear(size_t tables_) {
+            // every chunk is free once its rows are forgotten, including a partly used last one.
+            for (; begin < chunks.size(); ++begin) {
+                spare.push_back(chunks[begin]);
+            }
+
+            tables = tables_;
+            shift = 0;
+            while ((size_t(1) << shift) < tables) shift++;
+
+            // chunks of another size cannot be reused, so they are freed.
+            if (std::max(CHUNK_BITS, shift) != chunk_bits) {
+                chunk_bits = std::max(CHUNK_BITS, shift);
+                spare.clear();
+                owned.clear();
+                allocated = 0;
+                if (pool.is_mapped()) pool.resize(0, 0);
+            }
+
+            chunks.clear();
+            count = 0;
+            begin = 0;
         }
 
         void add_row() {
-            rows.emplace_back(rels.size());
+            size_t first = count;
+            count += size_t(1) << shift;
+
+            size_t chunk_size = size_t(1) << chunk_bits;
+            while (chunks.size() * chunk_size < count) {
+                if (!spare.empty()) {
+                    chunks.push_back(spare.back());
+                    spare.pop_back();
+                } else if (pool.is_mapped()) {
+                    // the pool never moves when it grows, so earlier chunks stay valid.
+                    size_t offset = pool.size();
+                    pool.resize(offset + chunk_size * sizeof(Row), 0);
+                    chunks.push_back(reinterpret_cast<Row *>(pool.data() + offset));
+                } else {
+                    chunks.push_back(owned.emplace_back(std::make_unique<Row[]>(chunk_size)).get());
+                    allocated += chunk_size * sizeof(Row);
+                }
+            }
+
+            std::fill_n(row(first >> shift), tables, Row());
+        }
+
+        /// Release every chunk that only holds rows of cosets before <code>coset</code>.
+        void del_rows_to(size_t coset) {
+            size_t end = std::min(coset, count >> shift) << shift >> chunk_bits;
+            for (; begin < end && begin < chunks.size(); ++begin) {
+                spare.push_back(chunks[begin]);
+            }
+        }
+
+        /// Bytes allocated for rows, live or spare.
+        [[nodiscard]] size_t bytes() const {
+            return allocated + pool.size();
+        }
+
+        /// The rows of <code>coset</code>, one per table.
+        [[nodiscard]] Row *row(size_t coset) {
+            size_t idx = coset << shift;
+            return chunks[idx >> chunk_bits] + (idx & ((size_t(1) << chunk_bits) - 1));
+        }
+
+        [[nodiscard]] Row &get(size_t coset, size_t table_idx) {
+            return row(coset)[table_idx];
+        }
+    };
+
+    /**
+     * The relation tables of a group, and the tables each generator appears in. These depend only on the Coxeter
+     * matrix, so they are built once and shared, read-only, by every solve of the same group.
+     */
+    struct Relations {
+        std::vector<Mult> mults;
+        std::vector<Group<>::Rel> rels;
+        std::vector<std::vector<size_t>> tables_for;
+        std::vector<std::vector<size_t>> commuting;  // commuting[gen]: generators h with m(gen, h) = 2
+        std::vector<Component> components;           // the classification, for order()
+
+        explicit Relations(Group<> const &group)
+            : mults(), rels(), tables_for(group.rank()), commuting(group.rank()), components(group.classify()) {
+            for (size_t i = 0; i < group.rank(); ++i) {
+                for (size_t j = 0; j < group.rank(); ++j) {
+                    mults.push_back(group.get(i, j));
+                }
+            }
+
+            for (size_t i = 0; i < group.rank(); ++i) {
+                for (size_t j = i + 1; j < group.rank(); ++j) {
+                    // The algorithm only works for Coxeter groups; multiplicities m_ii=1 are assumed. Relation tables
+                    // _may_ be added for them, but they are redundant and hurt performance so are skipped.
+                    if (i == j) continue;
+
+                    // Coxeter groups admit infinite multiplicities, represented by contexpr tc::FREE. Relation tables
+                    // for these should be skipped.
+                    auto m = group.get(i, j);
+
+                    if (m == FREE) {
+                        continue;
+                    }
+
+                    // Commuting generators need no relation table; see enumerate.
+                    if (m == 2) {
+                        commuting[i].push_back(j);
+                        commuting[j].push_back(i);
+                        continue;
+                    }
+
+                    rels.emplace_back(i, j, m);
+                }
+            }
+
+            size_t rel_idx = 0;
+            for (const auto &[i, j, m]: rels) {
+                tables_for[i].push_back(rel_idx);
+                tables_for[j].push_back(rel_idx);
+                rel_idx++;
+            }
+        }
+
+        /// True if these relations were built for a group with the same Coxeter matrix.
+        [[nodiscard]] bool matches(Group<> const &group) const {
+            if (mults.size() != group.rank() * group.rank()) return false;
+
+            for (size_t i = 0; i < group.rank(); ++i) {
+                for (size_t j = 0; j < group.rank(); ++j) {
+                    if (mults[i * group.rank() + j] != group.get(i, j)) return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    template<typename T, size_t N>
+    using Fixed = std::conditional_t<N == 0, std::vector<T>, std::array<T, N>>;
+
+    /**
+     * The relations as one enumeration kernel reads them. For a fixed Rank they are arrays on the stack with
+     * constant bounds, so the loops over them can be unrolled; for Rank 0 they are vectors sized for any rank.
+     */
+    template<size_t Rank>
+    struct Layout {
+        /// A relation table that involves some generator, and the other generator of that relation.
+        struct Link {
+            uint32_t table;
+            uint16_t other;
+            Mult m;
+        };
+
+        Fixed<Group<>::Rel, Rank * (Rank - 1) / 2> rels;
+        size_t rel_count;
+        Fixed<Fixed<Link, Rank ? Rank - 1 : 0>, Rank> links;  // links[gen][k] for k < link_count[gen]
+        Fixed<size_t, Rank> link_count;
+        Fixed<Fixed<uint16_t, Rank ? Rank - 1 : 0>, Rank> commuting;  // commuting[gen][k] for k < commuting_count[gen]
+        Fixed<size_t, Rank> commuting_count;
+
+        Layout(Relations const &relations, size_t rank)
+            : rels(), rel_count(relations.rels.size()), links(), link_count(), commuting(), commuting_count() {
+            if constexpr (Rank == 0) {
+                rels.resize(rel_count);
+                links.assign(rank, std::vector<Link>(rank));
+                link_count.assign(rank, 0);
+                commuting.assign(rank, std::vector<uint16_t>(rank));
+                commuting_count.assign(rank, 0);
+            }
+
+            std::copy(relations.rels.begin(), relations.rels.end(), rels.begin());
+            for (size_t gen = 0; gen < rank; ++gen) {
+                link_count[gen] = 0;
+                for (size_t table_idx: relations.tables_for[gen]) {
+                    auto const &[i, j, m] = relations.rels[table_idx];
+                    links[gen][link_count[gen]++] = {uint32_t(table_idx), uint16_t(i == gen ? j : i), m};
+                }
+
+                commuting_count[gen] = relations.commuting[gen].size();
+                std::copy(relations.commuting[gen].begin(), relations.commuting[gen].end(), commuting[gen].begin());
+            }
         }
     };
 
+    /**
+     * A product that is known to equal the newest coset.
+     */
+    template<typename Idx>
+    struct Fact {
+        Idx coset;
+        Idx gen;
+    };
+
+    /**
+     * Solver buffers that hold coset indexes, and so are stored at the same width as the coset table.
+     */
+    template<typename Idx>
+    struct Buffers {
+        std::vector<Idx> lst_vals;
+        std::vector<Fact<Idx>> facts;  // queue of products that equal the newest coset
+    };
+
+    /**
+     * Buffers a SolverWorkspace keeps between solves. They are cleared, but not freed, at the start of each solve.
+     */
+    struct SolverWorkspace::State {
+        std::string scratch;  // directory for scratch files, or empty to keep everything on the heap
+        std::shared_ptr<Relations const> relations;
+        Tables rel_tables;
+        std::vector<size_t> lst_free;  // loop slots in lst_vals whose loops have closed
+        std::tuple<Buffers<uint16_t>, Buffers<uint32_t>, Buffers<uint64_t>> buffers;
+        size_t capacity = 0;  // bytes in the last table, used to reserve the next one
+
+        // order() of the last subgroup solved with these relations, while predicted is set.
+        std::vector<size_t> predicted_idxs;
+        std::optional<std::optional<size_t>> predicted;
+
+        SolveOptions const *options = nullptr;  // limits of the running solve
+        size_t checkpoint = SIZE_MAX;           // order at which the limits are next checked
+        size_t emitted = 0;                     // rows already passed to the consumer
+
+        /// Bytes held by <code>cosets</code> and by these buffers.
+        [[nodiscard]] size_t bytes(Cosets<> const &cosets) const {
+            size_t res = cosets.size() * cosets.width() + rel_tables.bytes() + lst_free.capacity() * sizeof(size_t);
+            std::apply([&](auto const &...bufs) {
+                ((res += bufs.lst_vals.capacity() * sizeof(bufs.lst_vals[0])
+                         + bufs.facts.capacity() * sizeof(bufs.facts[0])), ...);
+            }, buffers);
+            return res;
+        }
+
+        /// Pass the rows before <code>end</code> that the consumer has not seen.
+        void emit(SolveOptions const &opts, Cosets<> const &cosets, size_t end) {
+            if (opts.consumer && end > emitted) {
+                opts.consumer(cosets, emitted, end);
+                emitted = end;
+            }
+        }
+
+        /// Report progress, and return the reason the running solve must stop, if any. Sets the next checkpoint.
+        [[nodiscard]] std::optional<StopReason> check(Cosets<> const &cosets, size_t scan) {
+            size_t interval = std::max<size_t>(options->interval, 1);
+            checkpoint = (cosets.order() / interval + 1) * interval;
+
+            if (options->progress) {
+                options->progress({cosets.order(), scan, cosets.order() - scan});
+            }
+            emit(*options, cosets, scan);
+            if (options->cancel && options->cancel->load(std::memory_order_relaxed)) {
+                return StopReason::Cancelled;
+            }
+            if (options->deadline && std::chrono::steady_clock::now() >= *options->deadline) {
+                return StopReason::Deadline;
+            }
+            if (options->max_bytes != SIZE_MAX && bytes(cosets) > options->max_bytes) {
+                return StopReason::Memory;
+            }
+            return std::nullopt;
+        }
+    };
+
+    SolverWorkspace::SolverWorkspace()
+        : _state(std::make_unique<State>()) {}
+
+    SolverWorkspace::SolverWorkspace(std::string const &scratch)
+        : _state(std::make_unique<State>()) {
+        _state->scratch = scratch;
+        _state->rel_tables.pool = Storage::mapped(scratch);
+    }
+
+    SolverWorkspace::SolverWorkspace(SolverWorkspace &&) noexcept = default;
+
+    SolverWorkspace &SolverWorkspace::operator=(SolverWorkspace &&) noexcept = default;
+
+    SolverWorkspace::~SolverWorkspace() = default;
+
+    /**
+     * Move the loop values to the buffers of a wider index type. Slot numbers are unchanged, so the free list stays
+     * valid.
+     */
+    template<typename From, typename To>
+    void promote(Buffers<From> &from, Buffers<To> &to) {
+        to.lst_vals.assign(from.lst_vals.begin(), from.lst_vals.end());
+        from.lst_vals.clear();
+    }
+
     [[nodiscard]] Cosets<> Group<>::solve(std::vector<size_t> const &idxs, size_t bound) const {
+        return solve(idxs, SolveOptions{bound});
+    }
+
+    [[nodiscard]] Cosets<> Group<>::solve(
+        std::vector<size_t> const &idxs, size_t bound, SolverWorkspace &workspace
+    ) const {
+        return solve(idxs, SolveOptions{bound}, workspace);
+    }
+
+    [[nodiscard]] Cosets<> Group<>::solve(std::vector<size_t> const &idxs, SolveOptions const &options) const {
+        SolverWorkspace workspace;
+        return solve(idxs, options, workspace);
+    }
+
+    [[nodiscard]] Cosets<> Group<>::solve(
+        std::vector<size_t> const &idxs, SolveOptions const &options, SolverWorkspace &workspace
+    ) const {
+        auto known = check_stops(idxs, options, workspace);
+
+        if (auto cached = cache_load(idxs, options.bound)) {
+            if (options.depth) cached->record_depth();
+            if (options.path) cached->record_path();
+            if (options.consumer) options.consumer(*cached, 0, cached->order());
+            return std::move(*cached);
+        }
+
+        auto cosets = solve_felsch(idxs, known, options, workspace);
+        cache_store(idxs, options.bound, cosets);
+        return cosets;
+    }
+
+    [[nodiscard]] Cosets<> Group<>::solve_felsch(
+        std::vector<size_t> const &idxs, std::optional<size_t> known, SolveOptions const &options,
+        SolverWorkspace &workspace
+    ) const {
+        size_t idx = 0;
+        Cosets<> cosets = start(idxs, known, options.bound, workspace);
+        resume(cosets, workspace, idx, options);
+        return cosets;
+    }
+
+    namespace {
+        bool limited(SolveOptions const &options) {
+            return options.bound != SIZE_MAX || options.cancel || options.deadline || options.max_bytes != SIZE_MAX;
+        }
+
+        [[noreturn]] void unlimited() {
+            throw std::invalid_argument("tc::Group::solve: the subgroup has infinite index and the solve has no limit");
+        }
+    }
+
+    void Group<>::check_stops(std::vector<size_t> const &idxs, SolveOptions const &options) const {
+        if (!limited(options) && !order(idxs)) {
+            unlimited();
+        }
+    }
+
+    std::optional<size_t> Group<>::check_stops(
+        std::vector<size_t> const &idxs, SolveOptions const &options, SolverWorkspace &workspace
+    ) const {
+        auto &state = *workspace._state;
+
+        if (!state.relations || !state.relations->matches(*this)) {
+            state.relations = std::make_shared<Relations const>(*this);
+            state.predicted.reset();
+        }
+        if (!state.predicted || state.predicted_idxs != idxs) {
+            state.predicted = order(idxs, state.relations->components);
+            state.predicted_idxs = idxs;
+        }
+
+        if (!limited(options) && !*state.predicted) {
+            unlimited();
+        }
+        return *state.predicted;
+    }
+
+    [[nodiscard]] Cosets<> Group<>::start(
+        std::vector<size_t> const &idxs, std::optional<size_t> known, size_t bound, SolverWorkspace &workspace
+    ) const {
+        auto &state = *workspace._state;
+
         // region Initialize Cosets Table
-        Cosets<> cosets(rank());
+        // The table starts with the narrowest index type and is promoted only if the order outgrows it. If the order
+        // is known, it is promoted at once, and reserved for exactly the cosets the solve will define.
+        size_t width = sizeof(uint16_t);
+        size_t bytes = state.capacity;
+        if (known) {
+            size_t rows = std::max<size_t>(std::min(*known, bound), 1);
+            if (rows > std::numeric_limits<uint32_t>::max()) {
+                width = sizeof(uint64_t);
+            } else if (rows > std::numeric_limits<uint16_t>::max()) {
+                width = sizeof(uint32_t);
+            }
+            bytes = rows <= SIZE_MAX / width / std::max<size_t>(rank(), 1) ? rows * width * rank() : 0;
+        }
+
+        Cosets<> cosets(*this);
+        if (!state.scratch.empty()) {
+            cosets._data = Storage::mapped(state.scratch);
+        }
+        cosets.reserve(width == sizeof(uint16_t) ? bytes : 0);
         cosets.add_row();
+        state.emitted = 0;
 
         if (rank() == 0) {
             cosets._complete = true;
@@ -53,42 +486,24 @@ namespace tc {
         // endregion
 
         // region Initialize Relation Tables
-        std::vector<Group<>::Rel> rels;
-        for (int i = 0; i < rank(); ++i) {
-            for (int j = i + 1; j < rank(); ++j) {
-                // The algorithm only works for Coxeter groups; multiplicities m_ii=1 are assumed. Relation tables
-                // _may_ be added for them, but they are redundant and hurt performance so are skipped.
-                if (i == j) continue;
+        auto const &rels = state.relations->rels;
 
-                // Coxeter groups admit infinite multiplicities, represented by contexpr tc::FREE. Relation tables
-                // for these should be skipped.
-                auto m = get(i, j);
+        Tables &rel_tables = state.rel_tables;
+        rel_tables.clear(rels.size());
 
-                if (m == FREE) {
-                    continue;
-                }
-
-                rels.emplace_back(i, j, m);
-            }
-        }
+        std::apply([](auto &...buffers) { (buffers.lst_vals.clear(), ...); }, state.buffers);
+        state.lst_free.clear();
+        auto &lst_vals = std::get<Buffers<uint16_t>>(state.buffers).lst_vals;
 
-        Tables rel_tables(rels);
-        std::vector<std::vector<size_t>> tables_for(rank());
-        int rel_idx = 0;
-        for (const auto &[i, j, m]: rels) {
-            tables_for[i].push_back(rel_idx);
-            tables_for[j].push_back(rel_idx);
-            rel_idx++;
-        }
+        TC_STAT(cosets._stats.loops_closed.assign(rels.size(), 0);)
 
-        std::vector<size_t> lst_vals;
         rel_tables.add_row();
-        for (int table_idx = 0; table_idx < rel_tables.size(); ++table_idx) {
-            const auto &[i, j, m] = rel_tables.rels[table_idx];
-            Row &row = rel_tables.rows[0][table_idx];
+        for (size_t table_idx = 0; table_idx < rel_tables.size(); ++table_idx) {
+            const auto &[i, j, m] = rels[table_idx];
+            Row &row = rel_tables.get(0, table_idx);
 
             if (!cosets.isset(0, i) && !cosets.isset(0, j)) {
-                row.lst_idx = lst_vals.size();
+                row.lst_idx(lst_vals.size());
                 lst_vals.push_back(0);
                 row.free = false;
                 row.gnr = 0;
@@ -96,62 +511,328 @@ namespace tc {
                 row.free = false;
                 row.gnr = 1;
                 row.idem = true;
+                TC_STAT(cosets._stats.idempotent_rows++;)
             }
         }
         // endregion
 
-        size_t idx = 0;
+        if (width >= sizeof(uint32_t)) {
+            cosets.promote(sizeof(uint32_t), width == sizeof(uint32_t) ? bytes : 0);
+            promote(std::get<0>(state.buffers), std::get<1>(state.buffers));
+        }
+        if (width >= sizeof(uint64_t)) {
+            cosets.promote(sizeof(uint64_t), bytes);
+            promote(std::get<1>(state.buffers), std::get<2>(state.buffers));
+        }
+
+        return cosets;
+    }
+
+    void Group<>::resume(
+        Cosets<> &cosets, SolverWorkspace &workspace, size_t &idx, SolveOptions const &options
+    ) const {
+        auto &state = *workspace._state;
+
+        // once recorded, depths and the path are kept up to date by every later resume.
+        if (options.depth && !cosets.has_depth()) {
+            cosets.record_depth();
+        }
+        if (options.path && !cosets.has_path()) {
+            cosets.record_path();
+        }
+
+        if (cosets.complete()) {
+            state.emit(options, cosets, cosets.order());
+            return;
+        }
+
+        size_t bound = options.bound;
+
+        // without reporting or limits, the checkpoint is never reached.
+        bool checked = options.progress || options.consumer || options.cancel || options.deadline
+                       || options.max_bytes != SIZE_MAX;
+        state.options = &options;
+        state.checkpoint = checked ? cosets.order() : SIZE_MAX;
+
+        while (true) {
+            if (cosets.width() == sizeof(uint16_t)) {
+                if (dispatch<uint16_t>(cosets, state, idx, bound)) break;
+                cosets.promote(sizeof(uint32_t), state.capacity);
+                promote(std::get<0>(state.buffers), std::get<1>(state.buffers));
+            } else if (cosets.width() == sizeof(uint32_t)) {
+                if (dispatch<uint32_t>(cosets, state, idx, bound)) break;
+                cosets.promote(sizeof(uint64_t), state.capacity);
+                promote(std::get<1>(state.buffers), std::get<2>(state.buffers));
+            } else {
+                dispatch<uint64_t>(cosets, state, idx, bound);
+                break;
+            }
+        }
+
+        state.capacity = cosets._data.size();
+        state.emit(options, cosets, cosets.complete() ? cosets.order() : idx / rank());
+        state.options = nullptr;
+    }
+
+    Solver::Solver(Group<> const &group, std::vector<size_t> const &idxs, size_t bound)
+        : Solver(group, idxs, bound, SolverWorkspace()) {}
+
+    // the solve is checked first, before start() reserves the table or creates a scratch file.
+    Solver::Solver(Group<> const &group, std::vector<size_t> const &idxs, size_t bound, SolverWorkspace workspace)
+        : _group(group), _idxs(idxs), _workspace(std::move(workspace)), _idx(0),
+          _cosets(_group.start(idxs, _group.check_stops(idxs, SolveOptions{bound}, _workspace), bound, _workspace)) {
+        _group.resume(_cosets, _workspace, _idx, SolveOptions{bound});
+    }
+
+    Solver::Solver(Solver &&) noexcept = default;
+
+    Solver::~Solver() = default;
+
+    Cosets<> const &Solver::extend(size_t bound) {
+        return extend(SolveOptions{bound});
+    }
+
+    Cosets<> const &Solver::extend(SolveOptions const &options) {
+        if (!_cosets.complete()) {
+            _group.check_stops(_idxs, options, _workspace);
+        }
+        _group.resume(_cosets, _workspace, _idx, options);
+        return _cosets;
+    }
+
+    [[nodiscard]] Cosets<> const &Solver::cosets() const {
+        return _cosets;
+    }
+
+    [[nodiscard]] Cosets<> Solver::release() && {
+        return std::move(_cosets);
+    }
+
+    namespace {
+        /**
+         * Run <code>op(worker, idx)</code> for every idx in <code>[0, count)</code> on <code>threads</code> workers.
+         * Each worker starts with an interleaved share of the indexes and takes from the back of its own deque; once
+         * that is empty it steals from the front of the others.
+         */
+        template<typename Op>
+        void steal_for(size_t threads, size_t count, Op const &op) {
+            struct Queue {
+                std::mutex mutex;
+                std::deque<size_t> items;
+            };
+
+            std::vector<Queue> queues(threads);
+            for (size_t idx = 0; idx < count; ++idx) {
+                queues[idx % threads].items.push_back(idx);
+            }
+
+            auto work = [&](size_t worker) {
+                while (true) {
+                    std::optional<size_t> idx;
+
+                    for (size_t k = 0; !idx && k < threads; ++k) {
+                        auto &queue = queues[(worker + k) % threads];
+                        std::lock_guard lock(queue.mutex);
+                        if (queue.items.empty()) continue;
+
+                        if (k == 0) {
+                            idx = queue.items.back();
+                            queue.items.pop_back();
+                        } else {
+                            idx = queue.items.front();
+                            queue.items.pop_front();
+                        }
+                    }
+
+                    // nothing spawns new work, so once every queue is empty the worker is done.
+                    if (!idx) return;
+
+                    op(worker, *idx);
+                }
+            };
+
+            std::vector<std::thread> workers;
+            for (size_t worker = 1; worker < threads; ++worker) {
+                workers.emplace_back(work, worker);
+            }
+            work(0);
+
+            for (auto &worker: workers) {
+                worker.join();
+            }
+        }
+    }
+
+    [[nodiscard]] std::vector<Cosets<>> Group<>::solve_all(
+        std::vector<std::vector<size_t>> const &subsets, size_t bound, unsigned threads
+    ) const {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::max<size_t>(1, std::min<size_t>(threads, subsets.size()));
+
+        // checked up front, since a worker cannot throw.
+        for (auto const &idxs: subsets) {
+            check_stops(idxs, SolveOptions{bound});
+        }
+
+        auto relations = std::make_shared<Relations const>(*this);
+
+        std::vector<SolverWorkspace> workspaces(threads);
+        for (auto &workspace: workspaces) {
+            workspace._state->relations = relations;
+        }
+
+        std::vector<std::optional<Cosets<>>> solved(subsets.size());
+        steal_for(threads, subsets.size(), [&](size_t worker, size_t idx) {
+            solved[idx].emplace(solve(subsets[idx], bound, workspaces[worker]));
+        });
+
+        std::vector<Cosets<>> res;
+        res.reserve(subsets.size());
+        for (auto &cosets: solved) {
+            res.push_back(std::move(*cosets));
+        }
+        return res;
+    }
+
+    template<typename Idx>
+    bool Group<>::dispatch(Cosets<> &cosets, SolverWorkspace::State &state, size_t &idx, size_t bound) const {
+        if (state.options && !state.options->specialize) {
+            return enumerate<Idx, 0>(cosets, state, idx, bound);
+        }
+
+        switch (rank()) {
+            case 2:
+                return enumerate<Idx, 2>(cosets, state, idx, bound);
+            case 3:
+                return enumerate<Idx, 3>(cosets, state, idx, bound);
+            case 4:
+                return enumerate<Idx, 4>(cosets, state, idx, bound);
+            case 5:
+                return enumerate<Idx, 5>(cosets, state, idx, bound);
+            case 6:
+                return enumerate<Idx, 6>(cosets, state, idx, bound);
+            case 7:
+                return enumerate<Idx, 7>(cosets, state, idx, bound);
+            case 8:
+                return enumerate<Idx, 8>(cosets, state, idx, bound);
+            default:
+                return enumerate<Idx, 0>(cosets, state, idx, bound);
+        }
+    }
+
+    template<typename Idx, size_t Rank>
+    bool Group<>::enumerate(Cosets<> &cosets, SolverWorkspace::State &state, size_t &idx, size_t bound) const {
+        constexpr Idx UNSET = std::numeric_limits<Idx>::max();
+
+        // a constant when Rank is given, so products are found by shifts and constant divisions.
+        size_t const gens = Rank ? Rank : rank();
+
+        Tables &rel_tables = state.rel_tables;
+        Layout<Rank> const layout(*state.relations, gens);
+        auto const &rels = layout.rels;
+        auto &[lst_vals, facts] = std::get<Buffers<Idx>>(state.buffers);
+        auto &lst_free = state.lst_free;
+
+        Idx *data = cosets.table<Idx>();
+        size_t size = cosets.size();
+
+        size_t facts_head;
         size_t fact_idx;
-        size_t coset, gen, target, lst;
+        size_t coset, gen, target;
+        Idx lst;
 
         while (true) {
             // find next unknown product
-            while (idx < cosets.size() and cosets.isset(idx))
+            while (idx < size and data[idx] != UNSET)
                 idx++;
 
             if (cosets.order() >= bound) {
-                return cosets;
+                cosets._stop = StopReason::Bound;
+                return true;
             }
 
             // if there are none, then return
-            if (idx == cosets.size()) {
-                // todo unrolled linked list interval
-//                rel_tables.del_rows_to(idx / ngens);  
-                break;
+            if (idx == size) {
+                cosets._complete = true;
+                return true;
+            }
+
+            if (cosets.order() >= state.checkpoint) {
+                if (auto stop = state.check(cosets, idx / gens)) {
+                    cosets._stop = *stop;
+                    return true;
+                }
+            }
+
+            // the unknown product must be a new coset, but its index must not collide with UNSET.
+            if (cosets.order() >= UNSET) {
+                return false;
             }
 
             // the unknown product must be a new coset, so add it
             target = cosets.order();
             cosets.add_row();
             rel_tables.add_row();
+            if (!cosets._depth.empty()) {
+                cosets.add_depth<Idx>(idx / gens);
+            }
+            if (cosets.has_path()) {
+                cosets._path.add(idx / gens, idx % gens);
+            }
+
+            data = cosets.table<Idx>();
+            size = cosets.size();
 
             // queue of products that equal target
-            std::queue<size_t> facts;
-            facts.push(idx);  // new product should be recorded and propagated
+            facts.clear();
+            facts_head = 0;
+            facts.push_back({Idx(idx / gens), Idx(idx % gens)});  // new product should be recorded and propagated
+            TC_STAT(cosets._stats.facts_pushed++;)
+            TC_STAT(cosets._stats.max_live_rows = std::max(cosets._stats.max_live_rows, target + 1 - idx / gens);)
 
-            // todo unrolled linked list interval
-//            rel_tables.del_rows_to(coset);
+            // every product of the cosets before idx is known, so their rows are never read again
+            rel_tables.del_rows_to(idx / gens);
 
             // find all products which also lead to target
-            while (!facts.empty()) {
-                fact_idx = facts.front();
-                facts.pop();
+            while (facts_head < facts.size()) {
+                coset = facts[facts_head].coset;
+                gen = facts[facts_head].gen;
+                facts_head++;
+                TC_STAT(cosets._stats.facts_popped++;)
 
-                // skip if this product was already learned
-                if (cosets.get(fact_idx) != -1) continue;
+                fact_idx = coset * gens + gen;
 
-                cosets.set(fact_idx, target);
+                // skip if this product was already learned
+                if (data[fact_idx] != UNSET) {
+                    TC_STAT(cosets._stats.facts_skipped++;)
+                    continue;
+                }
 
-                coset = fact_idx / rank();
-                gen = fact_idx % rank();
+                data[fact_idx] = target;
+                data[target * gens + gen] = coset;
+
+                // A commuting pair (gen, h) closes the square coset -gen- target -h- e -gen- d -h- coset. Every new
+                // product involves target, so the last side to be learned is always at target: once coset h = d and
+                // d gen = e are known, e h = target.
+                for (size_t k = 0; k < layout.commuting_count[gen]; ++k) {
+                    size_t h = layout.commuting[gen][k];
+                    Idx d = data[coset * gens + h];
+                    if (d == UNSET) continue;
+                    Idx e = data[d * gens + gen];
+                    if (e == UNSET) continue;
+                    facts.push_back({e, Idx(h)});
+                    TC_STAT(cosets._stats.facts_pushed++;)
+                }
 
                 // If the product stays within the coset todo
-                for (size_t table_idx: tables_for[gen]) {
-                    auto &[i, j, m] = rel_tables.rels[table_idx];
-                    auto &trow = rel_tables.rows[target][table_idx];
-                    auto &crow = rel_tables.rows[coset][table_idx];
-
-                    size_t other_gen = (i == gen) ? j : i;
+                Row *trows = rel_tables.row(target);
+                Row *crows = rel_tables.row(coset);
+                for (size_t k = 0; k < layout.link_count[gen]; ++k) {
+                    auto const &[table_idx, other_gen, m] = layout.links[gen][k];
+                    auto &trow = trows[table_idx];
+                    auto &crow = crows[table_idx];
 
                     // Test if loop is closed
                     if (trow.free) {
@@ -161,22 +842,27 @@ namespace tc {
                         if (target == coset) {
                             trow.idem = true;
                         }
+                        TC_STAT(if (trow.idem) cosets._stats.idempotent_rows++;)
 
                         if (trow.idem) {
                             if (trow.gnr == m) {
                                 // loop is closed, but idempotent, so the target links to itself via the other generator.
                                 // todo might be able to move this logic up into the (target == coset) block and avoid those computations.
-                                facts.push(target * rank() + other_gen);
+                                facts.push_back({Idx(target), Idx(other_gen)});
+                                TC_STAT(cosets._stats.facts_pushed++;)
+                                TC_STAT(cosets._stats.loops_closed[table_idx]++;)
                             }
                         } else {
                             if (trow.gnr == m - 1) {
                                 // loop is almost closed. record that the target closes this loop.
-                                lst_vals[trow.lst_idx] = target;
+                                lst_vals[trow.lst_idx()] = target;
                             } else if (trow.gnr == m) {
                                 // loop is closed. We know the last element in the loop must link with this one. 
-                                lst = lst_vals[trow.lst_idx];
-//                            delete trow.lst_ptr;
-                                facts.push(lst * rank() + other_gen);
+                                lst = lst_vals[trow.lst_idx()];
+                                lst_free.push_back(trow.lst_idx());
+                                facts.push_back({lst, Idx(other_gen)});
+                                TC_STAT(cosets._stats.facts_pushed++;)
+                                TC_STAT(cosets._stats.loops_closed[table_idx]++;)
                             }
                         }
                     }
@@ -185,27 +871,33 @@ namespace tc {
 
             // If any target row wasn't identified with a loop,
             // then assign it a new loop.
-            for (size_t table_idx = 0; table_idx < rel_tables.size(); table_idx++) {
-                auto &[i, j, m] = rel_tables.rels[table_idx];
-                auto &trow = rel_tables.rows[target][table_idx];
+            Row *trows = rel_tables.row(target);
+            for (size_t table_idx = 0; table_idx < layout.rel_count; table_idx++) {
+                auto &[i, j, m] = rels[table_idx];
+                auto &trow = trows[table_idx];
 
                 if (trow.free) {
-                    if ((cosets.get(target, i) != target) and
-                        (cosets.get(target, j) != target)) {
-                        trow.lst_idx = lst_vals.size();
+                    if ((data[target * gens + i] != target) and
+                        (data[target * gens + j] != target)) {
+                        if (lst_free.empty()) {
+                            trow.lst_idx(lst_vals.size());
+                            lst_vals.push_back(0);
+                        } else {
+                            trow.lst_idx(lst_free.back());
+                            lst_free.pop_back();
+                            lst_vals[trow.lst_idx()] = 0;
+                        }
                         trow.free = false;
-                        lst_vals.push_back(0);
                         trow.gnr = 0;
                     } else {
                         trow.free = false;
                         trow.gnr = 1;
                         trow.idem = true;
+                        TC_STAT(cosets._stats.idempotent_rows++;)
                     }
                 }
             }
+            TC_STAT(cosets._stats.max_facts = std::max(cosets._stats.max_facts, facts.size());)
         }
-
-        cosets._complete = true;
-        return cosets;
     }
 }
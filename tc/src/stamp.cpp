@@ -0,0 +1,127 @@
+#include <tc/core.hpp>
+
+#include <algorithm>
+
+#include "table.hpp"
+
+namespace tc {
+    namespace {
+        /// Dead cosets are dropped once the working table holds this many cosets. The limit doubles whenever that
+        /// frees less than half of the table.
+        constexpr size_t COMPACT_MIN = 1 << 12;
+
+        /**
+         * Mark every coset on the orbit of <code>coset</code> under <s_i, s_j> as stamped, if the relator
+         * <code>(i j)^m</code> closes there. The relator then holds on the whole orbit, so none of it needs scanning
+         * against this relation again. <code>marks</code> points at the flag for this relation on coset 0.
+         */
+        void mark(Table const &table, uint8_t *marks, size_t stride, size_t coset, size_t i, size_t j, Mult m) {
+            size_t cur = coset;
+            for (size_t k = 0; k < 2 * size_t(m); ++k) {
+                cur = table.get(cur, k % 2 == 0 ? i : j);
+                if (cur == Table::UNSET) return;
+            }
+            if (cur != coset) return;
+
+            for (size_t k = 0; k < 2 * size_t(m); ++k) {
+                marks[cur * stride] = 1;
+                cur = table.get(cur, k % 2 == 0 ? i : j);
+            }
+        }
+    }
+
+    [[nodiscard]] Cosets<> Group<>::solve_stamp(std::vector<size_t> const &idxs, size_t bound) const {
+        if (rank() == 0 || bound <= 1) {
+            return solve(idxs, bound);
+        }
+
+        check_stops(idxs, SolveOptions{bound});
+
+        if (auto cached = cache_load(idxs, bound)) {
+            return std::move(*cached);
+        }
+
+        std::vector<Rel> rels;
+        for (size_t i = 0; i < rank(); ++i) {
+            for (size_t j = i + 1; j < rank(); ++j) {
+                if (get(i, j) != FREE) {
+                    rels.emplace_back(i, j, get(i, j));
+                }
+            }
+        }
+
+        Table table(rank());
+        for (size_t g: idxs) {
+            if (g < rank())
+                table.set(0, g, 0);
+        }
+
+        // stamped[coset * rels.size() + rel] is set once the relation is known to hold on the coset's residue.
+        std::vector<uint8_t> stamped;
+        std::vector<std::pair<size_t, size_t>> merged;
+        table.merged = &merged;
+
+        // a merged coset's orbits are images of both cosets' orbits, so it keeps the marks of each.
+        auto settle = [&] {
+            stamped.resize(table.size() * rels.size(), 0);
+            for (auto [kept, dead]: merged) {
+                for (size_t rel = 0; rel < rels.size(); ++rel) {
+                    stamped[kept * rels.size() + rel] |= stamped[dead * rels.size() + rel];
+                }
+            }
+            merged.clear();
+        };
+
+        size_t limit = COMPACT_MIN;
+
+        for (size_t coset = 0; coset < table.size(); ++coset) {
+            if (!table.alive(coset)) continue;
+
+            for (size_t rel = 0; rel < rels.size(); ++rel) {
+                stamped.resize(table.size() * rels.size(), 0);
+                if (stamped[coset * rels.size() + rel]) continue;
+
+                // defines the rest of the residue at once; later cosets on it skip this relation.
+                const auto &[i, j, m] = rels[rel];
+                table.scan(coset, i, j, m, true);
+
+                settle();
+                if (!table.alive(coset)) break;
+
+                mark(table, &stamped[rel], rels.size(), coset, i, j, m);
+            }
+
+            for (size_t gen = 0; gen < rank() && table.alive(coset); ++gen) {
+                if (table.get(coset, gen) == Table::UNSET) {
+                    table.define(coset, gen);
+                }
+            }
+
+            if (table.size() >= limit) {
+                // compact() keeps the live cosets in order, so their marks move down the same way.
+                stamped.resize(table.size() * rels.size(), 0);
+                size_t count = 0;
+                for (size_t old = 0; old < table.size(); ++old) {
+                    if (!table.alive(old)) continue;
+                    auto row = stamped.begin() + ptrdiff_t(old * rels.size());
+                    std::copy_n(row, rels.size(), stamped.begin() + ptrdiff_t(count++ * rels.size()));
+                }
+                stamped.resize(count * rels.size());
+
+                coset = table.compact(coset + 1) - 1;
+
+                if (table.size() * 2 > limit) {
+                    limit *= 2;
+                }
+            }
+
+            if (table.live >= bound) {
+                return solve(idxs, bound);
+            }
+        }
+
+        Cosets<> cosets = standardize(table);
+        cache_store(idxs, bound, cosets);
+        return cosets;
+    }
+}
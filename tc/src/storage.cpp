@@ -0,0 +1,180 @@
+#include <tc/storage.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace tc {
+    namespace {
+        /// Address space reserved for each mapped storage. Only the part backed by the file is ever touched.
+        constexpr size_t RESERVE = size_t(1) << 40;
+
+        /// The scratch file grows by at least this much at a time.
+        constexpr size_t GROWTH = size_t(64) << 20;
+
+        [[noreturn]] void fail(char const *what) {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+    }
+
+    Storage::Storage() = default;
+
+    Storage Storage::mapped(std::string const &dir) {
+        Storage res;
+        res._dir = dir;
+
+        std::string path = dir + "/tc-XXXXXX";
+        res._fd = mkstemp(path.data());
+        if (res._fd < 0) fail("tc::Storage: cannot create scratch file");
+        unlink(path.c_str());
+
+        void *map = mmap(nullptr, RESERVE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, res._fd, 0);
+        if (map == MAP_FAILED) fail("tc::Storage: cannot map scratch file");
+        res._base = map;
+        res._length = RESERVE;
+        res._map = static_cast<uint8_t *>(map);
+
+        return res;
+    }
+
+    Storage Storage::view(std::string const &path, size_t offset, size_t bytes) {
+        Storage res;
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) fail("tc::Storage: cannot open file");
+
+        size_t length = std::max<size_t>(offset + bytes, 1);
+        void *map = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) fail("tc::Storage: cannot map file");
+
+        res._base = map;
+        res._length = length;
+        res._map = static_cast<uint8_t *>(map) + offset;
+        res._size = bytes;
+        res._capacity = bytes;
+
+        return res;
+    }
+
+    Storage::Storage(Storage const &other)
+        : Storage(other.fresh()) {
+        resize(other.size(), 0);
+        std::copy(other.data(), other.data() + other.size(), data());
+    }
+
+    Storage::Storage(Storage &&other) noexcept
+        : _heap(std::move(other._heap)),
+          _dir(std::move(other._dir)),
+          _fd(std::exchange(other._fd, -1)),
+          _base(std::exchange(other._base, nullptr)),
+          _length(std::exchange(other._length, 0)),
+          _map(std::exchange(other._map, nullptr)),
+          _size(std::exchange(other._size, 0)),
+          _capacity(std::exchange(other._capacity, 0)) {}
+
+    Storage &Storage::operator=(Storage const &other) {
+        if (this != &other) {
+            *this = Storage(other);
+        }
+        return *this;
+    }
+
+    Storage &Storage::operator=(Storage &&other) noexcept {
+        if (this != &other) {
+            release();
+            _heap = std::move(other._heap);
+            _dir = std::move(other._dir);
+            _fd = std::exchange(other._fd, -1);
+            _base = std::exchange(other._base, nullptr);
+            _length = std::exchange(other._length, 0);
+            _map = std::exchange(other._map, nullptr);
+            _size = std::exchange(other._size, 0);
+            _capacity = std::exchange(other._capacity, 0);
+        }
+        return *this;
+    }
+
+    Storage::~Storage() {
+        release();
+    }
+
+    void Storage::release() {
+        if (_base) munmap(_base, _length);
+        if (_fd >= 0) close(_fd);
+        _base = nullptr;
+        _map = nullptr;
+        _fd = -1;
+    }
+
+    [[nodiscard]] uint8_t *Storage::data() {
+        return _map ? _map : _heap.data();
+    }
+
+    [[nodiscard]] uint8_t const *Storage::data() const {
+        return _map ? _map : _heap.data();
+    }
+
+    [[nodiscard]] size_t Storage::size() const {
+        return _map ? _size : _heap.size();
+    }
+
+    [[nodiscard]] bool Storage::is_mapped() const {
+        return _map != nullptr;
+    }
+
+    void Storage::reserve(size_t bytes) {
+        if (!_map) {
+            _heap.reserve(bytes);
+            return;
+        }
+
+        if (bytes <= _capacity) return;
+        if (_fd < 0) {
+            errno = EROFS;
+            fail("tc::Storage: cannot grow a view of a file");
+        }
+        if (bytes > RESERVE) {
+            errno = ENOMEM;
+            fail("tc::Storage: scratch file exceeds reserved address space");
+        }
+        if (ftruncate(_fd, static_cast<off_t>(bytes)) != 0) fail("tc::Storage: cannot grow scratch file");
+        _capacity = bytes;
+    }
+
+    void Storage::resize(size_t bytes, uint8_t fill) {
+        if (!_map) {
+            _heap.resize(bytes, fill);
+            return;
+        }
+
+        if (bytes > _capacity) {
+            size_t capacity = std::max({_capacity + _capacity / 2, GROWTH});
+            reserve(std::max(bytes, std::min(capacity, RESERVE)));
+        }
+        if (bytes > _size) {
+            std::memset(_map + _size, fill, bytes - _size);
+        }
+        _size = bytes;
+    }
+
+    void Storage::assign(size_t bytes, uint8_t fill) {
+        if (!_map) {
+            _heap.assign(bytes, fill);
+            return;
+        }
+
+        _size = 0;
+        resize(bytes, fill);
+    }
+
+    [[nodiscard]] Storage Storage::fresh() const {
+        return _fd >= 0 ? mapped(_dir) : Storage();
+    }
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <tc/core.hpp>
+
+namespace tc {
+    /**
+     * @brief Working coset table for strategies that may define redundant cosets.
+     *
+     * Unlike Cosets<>, two cosets may turn out to coincide. The larger one is then forwarded to the smaller and its
+     * row merged in, which may reveal further coincidences. Dead cosets keep their rows until compact() is called.
+     * Every generator is an involution, so each entry is stored in both directions.
+     */
+    struct Table {
+        static constexpr size_t UNSET = Cosets<>::UNSET;
+
+        size_t rank;
+        size_t live;
+        std::vector<size_t> data;
+        std::vector<size_t> forward;  // forward[c] == c iff c is live; otherwise a smaller coset it coincides with
+        std::vector<size_t> queue;    // dead cosets whose rows are not yet merged
+
+        std::vector<std::pair<size_t, size_t>> *merged = nullptr;  // if set, every merge is logged as (kept, dead)
+
+        explicit Table(size_t rank)
+            : rank(rank), live(1), data(rank, UNSET), forward{0}, queue() {}
+
+        /// Number of cosets defined so far, live or dead.
+        [[nodiscard]] size_t size() const {
+            return forward.size();
+        }
+
+        [[nodiscard]] bool alive(size_t coset) const {
+            return forward[coset] == coset;
+        }
+
+        [[nodiscard]] size_t get(size_t coset, size_t gen) const {
+            return data[coset * rank + gen];
+        }
+
+        void set(size_t coset, size_t gen, size_t target) {
+            data[coset * rank + gen] = target;
+            data[target * rank + gen] = coset;
+        }
+
+        /// Define a new coset as the product of <code>coset</code> and <code>gen</code>.
+        size_t define(size_t coset, size_t gen) {
+            size_t target = size();
+            forward.push_back(target);
+            data.resize(data.size() + rank, UNSET);
+            set(coset, gen, target);
+            live++;
+            return target;
+        }
+
+        /// The live coset that <code>coset</code> coincides with.
+        size_t find(size_t coset) {
+            size_t root = coset;
+            while (forward[root] != root) {
+                root = forward[root];
+            }
+            while (forward[coset] != root) {
+                coset = std::exchange(forward[coset], root);
+            }
+            return root;
+        }
+
+        /**
+         * Record that <code>a</code> and <code>b</code> are the same coset and merge every coincidence that follows.
+         * @see Holt, Handbook of Computational Group Theory, procedure COINCIDENCE.
+         */
+        void coincidence(size_t a, size_t b) {
+            merge(a, b);
+
+            for (size_t head = 0; head < queue.size(); ++head) {
+                size_t dead = queue[head];
+
+                for (size_t gen = 0; gen < rank; ++gen) {
+                    size_t other = get(dead, gen);
+                    if (other == UNSET) continue;
+
+                    data[other * rank + gen] = UNSET;
+
+                    size_t mu = find(dead);
+                    size_t nu = find(other);
+                    if (get(mu, gen) != UNSET) {
+                        merge(nu, get(mu, gen));
+                    } else if (get(nu, gen) != UNSET) {
+                        merge(mu, get(nu, gen));
+                    } else {
+                        set(mu, gen, nu);
+                    }
+                }
+            }
+
+            queue.clear();
+        }
+
+        /**
+         * Trace the relator <code>(i j)^m</code> from <code>coset</code> in both directions. A single gap is filled by
+         * deduction and a closed trace that disagrees is a coincidence. With <code>fill</code>, larger gaps are
+         * closed by defining new cosets; otherwise they are left open.
+         */
+        void scan(size_t coset, size_t i, size_t j, Mult m, bool fill) {
+            auto letter = [&](size_t k) { return k % 2 == 0 ? i : j; };
+
+            size_t fwd = coset, bwd = coset;
+            size_t lo = 0, hi = 2 * size_t(m);
+
+            while (true) {
+                while (lo < hi && get(fwd, letter(lo)) != UNSET) {
+                    fwd = get(fwd, letter(lo++));
+                }
+                if (lo == hi) {
+                    if (fwd != bwd) coincidence(fwd, bwd);
+                    return;
+                }
+
+                while (hi > lo && get(bwd, letter(hi - 1)) != UNSET) {
+                    bwd = get(bwd, letter(--hi));
+                }
+                if (lo == hi) {
+                    if (fwd != bwd) coincidence(fwd, bwd);
+                    return;
+                }
+                if (lo + 1 == hi) {
+                    set(fwd, letter(lo), bwd);
+                    return;
+                }
+
+                if (!fill) return;
+                define(fwd, letter(lo));
+            }
+        }
+
+        /**
+         * Drop dead cosets and renumber the live ones, keeping their order. Returns the new index of the first live
+         * coset at or after <code>pos</code>.
+         */
+        size_t compact(size_t pos) {
+            std::vector<size_t> label(size(), UNSET);
+            size_t count = 0;
+            size_t res = UNSET;
+            for (size_t coset = 0; coset < size(); ++coset) {
+                if (coset == pos) res = count;
+                if (alive(coset)) label[coset] = count++;
+            }
+            if (res == UNSET) res = count;
+
+            for (size_t coset = 0; coset < size(); ++coset) {
+                if (!alive(coset)) continue;
+
+                for (size_t gen = 0; gen < rank; ++gen) {
+                    size_t target = get(coset, gen);
+                    data[label[coset] * rank + gen] = target == UNSET ? UNSET : label[target];
+                }
+            }
+
+            data.resize(count * rank);
+            forward.resize(count);
+            for (size_t coset = 0; coset < count; ++coset) {
+                forward[coset] = coset;
+            }
+
+            return res;
+        }
+
+    private:
+        void merge(size_t a, size_t b) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return;
+            if (a > b) std::swap(a, b);
+
+            forward[b] = a;
+            queue.push_back(b);
+            if (merged) merged->emplace_back(a, b);
+            live--;
+        }
+    };
+}
@@ -0,0 +1,426 @@
+#include <tc/core.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+namespace tc {
+    namespace {
+        constexpr size_t UNSET = Cosets<>::UNSET;
+
+        /**
+         * One link <code>K' = K - {s}</code> of a chain of standard parabolic subgroups.
+         *
+         * Every coset of W_K' in W_K has a minimal representative b. By Deodhar's lemma, for each generator s in K
+         * either <code>b s</code> is the minimal representative of another coset, or <code>b s = t b</code> for some
+         * generator t in K'. The link records the coset table and, for the second case, the label t.
+         */
+        struct Link {
+            std::vector<size_t> gens;    // generators of K, as indexes into the full group
+            std::vector<size_t> sub;     // generators of K', as indexes into gens
+            std::vector<size_t> local;   // index of each generator of the full group in gens, or UNSET if not in K
+            size_t order = 0;
+            size_t stride = 0;           // product of the orders of the links below this one
+            std::vector<size_t> table;   // table[b * |K| + s]: coset of b s
+            std::vector<size_t> labels;  // labels[b * |K| + s]: t such that b s = t b if s fixes b, else UNSET
+            bool valid = false;
+        };
+
+        /**
+         * Run <code>op(begin, end)</code> over <code>threads</code> contiguous slices of <code>[0, count)</code>.
+         */
+        template<typename Op>
+        void parallel_for(size_t threads, size_t count, Op const &op) {
+            threads = std::max<size_t>(1, std::min(threads, count));
+
+            std::vector<std::thread> workers;
+            for (size_t t = 1; t < threads; ++t) {
+                workers.emplace_back(op, count * t / threads, count * (t + 1) / threads);
+            }
+            op(0, count / threads);
+
+            for (auto &worker: workers) {
+                worker.join();
+            }
+        }
+
+        /**
+         * Choose the chain <code>J = K_0 < K_1 < ... < K_n = S</code> by removing one generator at a time from the
+         * top. Generators with the fewest non-commuting neighbours go first; in the usual diagrams these are leaves,
+         * which keeps each link small. Links are returned bottom-up.
+         */
+        std::vector<Link> chain(Group<> const &group, std::vector<bool> const &fixed) {
+            std::vector<Link> links;
+
+            std::vector<size_t> gens;
+            for (size_t s = 0; s < group.rank(); ++s) {
+                gens.push_back(s);
+            }
+
+            while (true) {
+                size_t best = UNSET;
+                size_t best_degree = UNSET;
+                for (size_t l = 0; l < gens.size(); ++l) {
+                    if (fixed[gens[l]]) continue;
+
+                    size_t degree = 0;
+                    for (size_t t: gens) {
+                        if (t != gens[l] && group.get(gens[l], t) != 2) degree++;
+                    }
+
+                    if (degree <= best_degree) {
+                        best = l;
+                        best_degree = degree;
+                    }
+                }
+
+                if (best == UNSET) break;
+
+                Link link;
+                link.gens = gens;
+                link.local.assign(group.rank(), UNSET);
+                for (size_t l = 0; l < gens.size(); ++l) {
+                    link.local[gens[l]] = l;
+                    if (l != best) link.sub.push_back(l);
+                }
+                links.push_back(std::move(link));
+
+                gens.erase(gens.begin() + best);
+            }
+
+            std::reverse(links.begin(), links.end());
+            return links;
+        }
+
+        /**
+         * Copy the table of K' in K from <code>cosets</code>, a complete table of <code>sub</code>, and label each
+         * fixed point.
+         *
+         * Labels are found in breadth-first order. If s fixes b and b has parent <code>b g</code>, the orbit of b
+         * under g and s is a path of m = m(g, s) cosets with b at one end. The other end d is shorter than b and is
+         * fixed by r, the m-th letter of <code>g s g ...</code>; then <code>b s b^-1 = d r d^-1</code>.
+         *
+         * Leaves the link invalid if the table is not consistent with this.
+         */
+        void label_link(Group<> const &sub, Link &link, Cosets<> const &cosets) {
+            size_t rank = link.gens.size();
+            size_t order = cosets.order();
+            link.order = order;
+            link.table.resize(order * rank);
+            for (size_t idx = 0; idx < link.table.size(); ++idx) {
+                link.table[idx] = cosets.get(idx / rank, idx % rank);
+            }
+
+            auto const &table = link.table;
+
+            std::vector<size_t> queue = {0};
+            std::vector<size_t> depth(order, UNSET);
+            std::vector<size_t> parent(order, UNSET);
+            depth[0] = 0;
+            for (size_t head = 0; head < queue.size(); ++head) {
+                size_t b = queue[head];
+                for (size_t g = 0; g < rank; ++g) {
+                    size_t c = table[b * rank + g];
+                    if (depth[c] != UNSET) continue;
+
+                    depth[c] = depth[b] + 1;
+                    parent[c] = g;
+                    queue.push_back(c);
+                }
+            }
+
+            auto &labels = link.labels;
+            labels.assign(order * rank, UNSET);
+            for (size_t b: queue) {
+                for (size_t s = 0; s < rank; ++s) {
+                    if (table[b * rank + s] != b) continue;
+
+                    if (b == 0) {
+                        labels[s] = link.gens[s];
+                        continue;
+                    }
+
+                    size_t g = parent[b];
+                    Mult m = sub.get(g, s);
+                    if (m == FREE) return;
+
+                    size_t d = b;
+                    for (size_t step = 0; step + 1 < m; ++step) {
+                        d = table[d * rank + (step % 2 == 0 ? g : s)];
+                    }
+                    size_t r = (m - 1) % 2 == 0 ? g : s;
+
+                    if (table[d * rank + r] != d || depth[d] >= depth[b]) return;
+
+                    labels[b * rank + s] = labels[d * rank + r];
+                }
+            }
+
+            link.valid = true;
+        }
+
+        /**
+         * Solve the cosets of K' in K and label each fixed point. Leaves the link invalid if it is not finite within
+         * the bound.
+         */
+        void solve_link(Group<> const &group, Link &link, size_t bound) {
+            Group<> sub = group.sub(link.gens);
+
+            Cosets<> cosets = sub.solve(link.sub, bound);
+            if (!cosets.complete()) return;
+
+            label_link(sub, link, cosets);
+        }
+
+        /**
+         * Fill rows <code>[begin, end)</code> of the table. Coset c has digit <code>(c / stride) % order</code> in each
+         * link; generators are resolved from the top link down, following labels through each fixed point.
+         */
+        template<typename Idx>
+        void assemble(Idx *data, size_t rank, std::vector<Link> const &links, size_t begin, size_t end) {
+            std::vector<size_t> digits(links.size());
+
+            for (size_t c = begin; c < end; ++c) {
+                size_t rem = c;
+                for (size_t k = 0; k < links.size(); ++k) {
+                    digits[k] = rem % links[k].order;
+                    rem /= links[k].order;
+                }
+
+                for (size_t s = 0; s < rank; ++s) {
+                    size_t target = c;
+                    size_t gen = s;
+
+                    for (size_t k = links.size(); k-- > 0;) {
+                        auto const &link = links[k];
+                        size_t l = link.local[gen];
+                        size_t a = digits[k];
+                        size_t next = link.table[a * link.gens.size() + l];
+
+                        if (next != a) {
+                            target = c - a * link.stride + next * link.stride;
+                            break;
+                        }
+
+                        gen = link.labels[a * link.gens.size() + l];
+                    }
+
+                    data[c * rank + s] = static_cast<Idx>(target);
+                }
+            }
+        }
+
+        /**
+         * Renumber the cosets in breadth-first order, visiting generators in index order. This is the order in which
+         * the serial solve defines them.
+         */
+        template<typename Idx>
+        void renumber(Storage &bytes, size_t rank, size_t order, size_t threads) {
+            Idx const *data = reinterpret_cast<Idx const *>(bytes.data());
+
+            std::vector<Idx> queue(order);
+            std::vector<Idx> label(order, std::numeric_limits<Idx>::max());
+            size_t tail = 1;
+            queue[0] = 0;
+            label[0] = 0;
+            for (size_t head = 0; head < tail; ++head) {
+                size_t c = queue[head];
+                for (size_t s = 0; s < rank; ++s) {
+                    Idx n = data[c * rank + s];
+                    if (label[n] != std::numeric_limits<Idx>::max()) continue;
+
+                    label[n] = static_cast<Idx>(tail);
+                    queue[tail++] = n;
+                }
+            }
+
+            Storage result = bytes.fresh();
+            result.resize(bytes.size(), 0);
+            Idx *out = reinterpret_cast<Idx *>(result.data());
+            parallel_for(threads, order, [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; ++c) {
+                    size_t old = queue[c];
+                    for (size_t s = 0; s < rank; ++s) {
+                        out[c * rank + s] = label[data[old * rank + s]];
+                    }
+                }
+            });
+
+            bytes = std::move(result);
+        }
+    }
+
+    template<typename Links>
+    [[nodiscard]] Cosets<> Group<>::combine(
+        Links const &links, size_t order, unsigned threads, bool serial_order
+    ) const {
+        Cosets<> cosets(*this);
+        cosets.resize(order);
+        cosets._complete = true;
+
+        parallel_for(threads, order, [&](size_t begin, size_t end) {
+            switch (cosets._width) {
+                case sizeof(uint16_t):
+                    return assemble(cosets.table<uint16_t>(), rank(), links, begin, end);
+                case sizeof(uint32_t):
+                    return assemble(cosets.table<uint32_t>(), rank(), links, begin, end);
+                default:
+                    return assemble(cosets.table<uint64_t>(), rank(), links, begin, end);
+            }
+        });
+
+        if (serial_order) {
+            switch (cosets._width) {
+                case sizeof(uint16_t):
+                    renumber<uint16_t>(cosets._data, rank(), order, threads);
+                    break;
+                case sizeof(uint32_t):
+                    renumber<uint32_t>(cosets._data, rank(), order, threads);
+                    break;
+                default:
+                    renumber<uint64_t>(cosets._data, rank(), order, threads);
+                    break;
+            }
+        }
+
+        return cosets;
+    }
+
+    [[nodiscard]] Cosets<> Group<>::solve(
+        std::vector<size_t> const &idxs, size_t bound, unsigned threads, bool serial_order
+    ) const {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        if (threads == 1 || rank() == 0) {
+            return solve(idxs, bound);
+        }
+
+        check_stops(idxs, SolveOptions{bound});
+
+        // only the serial numbering is cached; any fallback to the serial solve below checks the cache itself.
+        if (serial_order) {
+            if (auto cached = cache_load(idxs, bound)) {
+                return std::move(*cached);
+            }
+        }
+
+        std::vector<bool> fixed(rank(), false);
+        for (size_t g: idxs) {
+            if (g < rank())
+                fixed[g] = true;
+        }
+
+        // region Solve Links
+        std::vector<Link> links = chain(*this, fixed);
+
+        std::atomic<size_t> next = 0;
+        parallel_for(threads, links.size(), [&](size_t, size_t) {
+            for (size_t k; (k = next++) < links.size();) {
+                solve_link(*this, links[k], bound);
+            }
+        });
+
+        size_t order = 1;
+        for (auto &link: links) {
+            // a link that is infinite or past the bound, or an order that reaches the bound, leaves the result
+            // incomplete. Only the serial solve defines which cosets an incomplete table contains.
+            if (!link.valid || order > bound / link.order) {
+                return solve(idxs, bound);
+            }
+
+            link.stride = order;
+            order *= link.order;
+        }
+
+        if (order >= bound) {
+            return solve(idxs, bound);
+        }
+        // endregion
+
+        Cosets<> cosets = combine(links, order, threads, serial_order);
+        if (serial_order) {
+            cache_store(idxs, bound, cosets);
+        }
+        return cosets;
+    }
+
+    [[nodiscard]] Cosets<> Group<>::compose(
+        Cosets<> const &outer, Cosets<> const &inner, bool serial_order, unsigned threads
+    ) const {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        if (!outer.complete() || !inner.complete()) {
+            throw std::invalid_argument("tc::Group::compose: tables must be complete");
+        }
+        if (outer.rank() != rank()) {
+            throw std::invalid_argument("tc::Group::compose: outer table is not for this group");
+        }
+
+        // region Recover Subgroups
+        // s is in a standard parabolic subgroup iff it fixes the initial coset.
+        std::vector<size_t> k;
+        for (size_t s = 0; s < rank(); ++s) {
+            if (outer.get(0, s) == 0) k.push_back(s);
+        }
+        Group<> sub_k = sub(k);
+
+        for (size_t a = 0; a < rank(); ++a) {
+            for (size_t b = 0; b < rank(); ++b) {
+                if (outer._mults[a * rank() + b] != get(a, b)) {
+                    throw std::invalid_argument("tc::Group::compose: outer table is not for this group");
+                }
+            }
+        }
+        if (inner.rank() != k.size()) {
+            throw std::invalid_argument("tc::Group::compose: inner table is not for the subgroup of outer");
+        }
+        for (size_t a = 0; a < k.size(); ++a) {
+            for (size_t b = 0; b < k.size(); ++b) {
+                if (inner._mults[a * k.size() + b] != sub_k.get(a, b)) {
+                    throw std::invalid_argument("tc::Group::compose: inner table is not for the subgroup of outer");
+                }
+            }
+        }
+
+        std::vector<size_t> j;
+        for (size_t s = 0; s < k.size(); ++s) {
+            if (inner.get(0, s) == 0) j.push_back(s);
+        }
+        // endregion
+
+        // region Label Links
+        // the inner link is W_K over W_J, with stride 1; the outer link is W over W_K.
+        std::vector<Link> links(2);
+
+        Link &low = links[0];
+        low.gens = k;
+        low.sub = j;
+        low.local.assign(rank(), UNSET);
+        for (size_t l = 0; l < k.size(); ++l) {
+            low.local[k[l]] = l;
+        }
+        label_link(sub_k, low, inner);
+
+        Link &high = links[1];
+        for (size_t s = 0; s < rank(); ++s) {
+            high.gens.push_back(s);
+            high.local.push_back(s);
+        }
+        high.sub = k;
+        label_link(*this, high, outer);
+
+        if (!low.valid || !high.valid) {
+            throw std::invalid_argument("tc::Group::compose: tables are not coset tables of parabolic subgroups");
+        }
+
+        low.stride = 1;
+        high.stride = low.order;
+        // endregion
+
+        return combine(links, low.order * high.order, threads, serial_order);
+    }
+}
@@ -1,8 +1,19 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include <tc/groups.hpp>
 #include <tc/core.hpp>
+#include <tc/automaton.hpp>
+#include <tc/cache.hpp>
 
 #include <gtest/gtest.h>
 
@@ -48,6 +59,24 @@ testing::AssertionResult AssertSolveOrder(
 
 #define EXPECT_SOLVE_ORDER(group, sub_gens, expected_order) EXPECT_PRED_FORMAT3(AssertSolveOrder, group, sub_gens, expected_order);
 
+/// heap allocations made so far, for checking that a reused workspace does not allocate
+std::atomic<size_t> allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+// not inlined, so the compiler does not pair the free with a new expression at the call site.
+[[gnu::noinline]] void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
 using v = std::vector<size_t>;
 
 tc::Group<> A(unsigned int n) {
@@ -209,6 +238,862 @@ TEST(solve, T) {
     EXPECT_SOLVE_ORDER(T(400, 300), v({0, 2}), 120000);
 }
 
+/// helper for comparing two solutions entry by entry
+testing::AssertionResult AssertSameCosets(
+    const char *expected_expr,
+    const char *actual_expr,
+    const tc::Cosets<> &expected,
+    const tc::Cosets<> &actual
+) {
+    if (expected.rank() != actual.rank() || expected.order() != actual.order()
+        || expected.complete() != actual.complete()) {
+        return testing::AssertionFailure()
+            << actual_expr << " has rank " << actual.rank() << ", order " << actual.order()
+            << " but " << expected_expr << " has rank " << expected.rank() << ", order " << expected.order() << ".";
+    }
+
+    for (size_t coset = 0; coset < expected.order(); ++coset) {
+        for (size_t gen = 0; gen < expected.rank(); ++gen) {
+            if (expected.get(coset, gen) != actual.get(coset, gen)) {
+                return testing::AssertionFailure()
+                    << actual_expr << " differs from " << expected_expr
+                    << " at coset " << coset << ", generator " << gen << ".";
+            }
+        }
+    }
+
+    return testing::AssertionSuccess();
+}
+
+#define EXPECT_SAME_COSETS(expected, actual) EXPECT_PRED_FORMAT2(AssertSameCosets, expected, actual);
+
+TEST(solve, workspace) {
+    tc::SolverWorkspace workspace;
+
+    // reuse one workspace across groups of different rank and across bounded and complete solves.
+    EXPECT_SAME_COSETS(B(5).solve({}), B(5).solve({}, SIZE_MAX, workspace));
+    EXPECT_SAME_COSETS(B(5).solve({0, 2}), B(5).solve({0, 2}, SIZE_MAX, workspace));
+    EXPECT_SAME_COSETS(E(6).solve({2}), E(6).solve({2}, SIZE_MAX, workspace));
+    EXPECT_SAME_COSETS(I2(5).solve({}), I2(5).solve({}, SIZE_MAX, workspace));
+    EXPECT_SAME_COSETS(H(4).solve({}, 1000), H(4).solve({}, 1000, workspace));
+    EXPECT_SAME_COSETS(H(4).solve({}), H(4).solve({}, SIZE_MAX, workspace));
+    EXPECT_SAME_COSETS(A(3).solve({0}), A(3).solve({0}, SIZE_MAX, workspace));
+
+    // relation rows sized for a group with thousands of relation tables are freed, not counted against later solves.
+    tc::Group<> dense(100);
+    for (size_t i = 0; i < dense.rank(); ++i) {
+        for (size_t j = i + 1; j < dense.rank(); ++j) {
+            dense.set(i, j, 3);
+        }
+    }
+    (void) dense.solve({}, 20, workspace);
+
+    tc::SolveOptions options;
+    options.max_bytes = 1 << 20;
+    options.interval = 1;
+    EXPECT_SAME_COSETS(B(5).solve({}), B(5).solve({}, options, workspace));
+
+    // every chunk of relation rows, including a partly used last one, is reused by the next solve, so many solves on
+    // one workspace fit in the budget of a few.
+    auto group = H(3);
+    for (size_t k = 0; k < 300; ++k) {
+        auto cosets = group.solve(k % 2 ? v{} : v{0}, options, workspace);
+        ASSERT_TRUE(cosets.complete()) << "solve " << k;
+    }
+}
+
+TEST(solve, allocations) {
+    // once warmed up, a solve allocates only the returned table: its entries and its copy of the Coxeter matrix.
+    auto group = E(6);
+    tc::SolverWorkspace workspace;
+    for (auto const &idxs: {v{}, v{2}, v{0, 1, 2}}) {
+        for (int k = 0; k < 2; ++k) {
+            (void) group.solve(idxs, SIZE_MAX, workspace);
+        }
+
+        size_t before = allocations;
+        auto cosets = group.solve(idxs, SIZE_MAX, workspace);
+        EXPECT_LE(allocations - before, 2) << "idxs of size " << idxs.size();
+        EXPECT_EQ(cosets.order(), group.order(idxs));
+    }
+}
+
+TEST(solve, width) {
+    EXPECT_EQ(A(4).solve({}).width(), 2);
+    EXPECT_EQ(E(6).solve({}).width(), 2);
+    EXPECT_EQ(B(7).solve({}, 65535).width(), 2);
+    EXPECT_EQ(B(7).solve({}, 65536).width(), 4);
+    EXPECT_EQ(B(7).solve({}).width(), 4);
+
+    // promoting the table must not change any entry.
+    auto narrow = T(400).solve({}, 65535);
+    auto wide = T(400).solve({});
+    for (size_t coset = 0; coset < narrow.order(); ++coset) {
+        for (size_t gen = 0; gen < narrow.rank(); ++gen) {
+            if (narrow.isset(coset, gen) && narrow.get(coset, gen) < narrow.order()) {
+                ASSERT_EQ(narrow.get(coset, gen), wide.get(coset, gen));
+            }
+        }
+    }
+}
+
+TEST(solve, threads) {
+    // with serial_order the table must match the serial solve exactly.
+    EXPECT_SAME_COSETS(B(6).solve({}), B(6).solve({}, SIZE_MAX, 4, true));
+    EXPECT_SAME_COSETS(D(6).solve({0, 3}), D(6).solve({0, 3}, SIZE_MAX, 4, true));
+    EXPECT_SAME_COSETS(E(6).solve({2}), E(6).solve({2}, SIZE_MAX, 4, true));
+    EXPECT_SAME_COSETS(H(4).solve({}), H(4).solve({}, SIZE_MAX, 3, true));
+    EXPECT_SAME_COSETS(T(50, 30).solve({0}), T(50, 30).solve({0}, SIZE_MAX, 2, true));
+    EXPECT_EQ(B(7).solve({}, SIZE_MAX, 4, true).width(), 4);
+
+    // incomplete solves fall back to the serial solve.
+    EXPECT_SAME_COSETS(H(4).solve({}, 1000), H(4).solve({}, 1000, 4));
+    EXPECT_SAME_COSETS(H(4).solve({}, 14400), H(4).solve({}, 14400, 4));
+    EXPECT_SAME_COSETS(tc::coxeter("{3 * 6}").solve({}, 10000), tc::coxeter("{3 * 6}").solve({}, 10000, 4));
+
+    // otherwise the numbering differs, but each generator must still act as an involution fixing the subgroup.
+    for (auto const &[group, gens]: std::vector<std::tuple<tc::Group<>, v>>{
+        {B(6), {}}, {E(6), {1, 4}}, {F4(), {0}}, {H(3), {0, 1, 2}}, {A(5), {1, 2}},
+    }) {
+        auto expected = group.solve(gens);
+        auto actual = group.solve(gens, SIZE_MAX, 4);
+
+        ASSERT_EQ(expected.order(), actual.order());
+        ASSERT_TRUE(actual.complete());
+        for (size_t gen: gens) {
+            ASSERT_EQ(actual.get(0, gen), 0);
+        }
+        for (size_t coset = 0; coset < actual.order(); ++coset) {
+            for (size_t gen = 0; gen < actual.rank(); ++gen) {
+                ASSERT_EQ(actual.get(actual.get(coset, gen), gen), coset);
+            }
+        }
+    }
+}
+
+TEST(solve, solve_all) {
+    std::vector<v> subsets;
+    for (size_t mask = 0; mask < 64; ++mask) {
+        auto &gens = subsets.emplace_back();
+        for (size_t gen = 0; gen < 6; ++gen) {
+            if (mask & (1 << gen)) gens.push_back(gen);
+        }
+    }
+
+    for (auto const &group: {E(6), B(6), D(6)}) {
+        auto solved = group.solve_all(subsets, SIZE_MAX, 3);
+        ASSERT_EQ(solved.size(), subsets.size());
+        for (size_t k = 0; k < subsets.size(); ++k) {
+            EXPECT_SAME_COSETS(group.solve(subsets[k]), solved[k]);
+        }
+    }
+
+    auto bounded = H(4).solve_all({{}, {0}, {1, 2}}, 1000);
+    EXPECT_SAME_COSETS(H(4).solve({}, 1000), bounded[0]);
+    EXPECT_SAME_COSETS(H(4).solve({0}, 1000), bounded[1]);
+    EXPECT_SAME_COSETS(H(4).solve({1, 2}, 1000), bounded[2]);
+
+    EXPECT_TRUE(A(3).solve_all({}).empty());
+
+    // labelled tables index the whole group's generators, not the subset's.
+    tc::Group<char> labelled(A(3), {'a', 'b', 'c'});
+    auto by_label = labelled.solve_all({{'b', 'c'}, {}});
+    auto raw = A(3).solve({1, 2});
+    ASSERT_EQ(by_label[0].order(), raw.order());
+    for (size_t coset = 0; coset < raw.order(); ++coset) {
+        EXPECT_EQ(by_label[0].get(coset, 'a'), raw.get(coset, 0));
+        EXPECT_EQ(by_label[0].get(coset, 'b'), raw.get(coset, 1));
+        EXPECT_EQ(by_label[0].get(coset, 'c'), raw.get(coset, 2));
+    }
+    EXPECT_EQ(by_label[1].gens(), labelled.gens());
+}
+
+TEST(solve, strategy) {
+    using tc::Strategy;
+
+    EXPECT_SAME_COSETS(A(5).solve({}), A(5).solve({}, SIZE_MAX, Strategy::HLT));
+    EXPECT_SAME_COSETS(B(6).solve({}), B(6).solve({}, SIZE_MAX, Strategy::HLT));
+    EXPECT_SAME_COSETS(D(6).solve({0, 3}), D(6).solve({0, 3}, SIZE_MAX, Strategy::HLT));
+    EXPECT_SAME_COSETS(E(6).solve({}), E(6).solve({}, SIZE_MAX, Strategy::HLT));
+    EXPECT_SAME_COSETS(F4().solve({1}), F4().solve({1}, SIZE_MAX, Strategy::HLT));
+    EXPECT_SAME_COSETS(H(4).solve({}), H(4).solve({}, SIZE_MAX, Strategy::HLT));
+    EXPECT_SAME_COSETS(T(40, 30).solve({0}), T(40, 30).solve({0}, SIZE_MAX, Strategy::HLT));
+    EXPECT_SAME_COSETS(I2(7).solve({0, 1}), I2(7).solve({0, 1}, SIZE_MAX, Strategy::HLT));
+
+    // incomplete solves are defined by the Felsch strategy.
+    EXPECT_SAME_COSETS(H(4).solve({}, 1000), H(4).solve({}, 1000, Strategy::HLT));
+    EXPECT_SAME_COSETS(H(4).solve({}, 14400), H(4).solve({}, 14400, Strategy::HLT));
+    EXPECT_SAME_COSETS(tc::coxeter("5 3 5").solve({}, 5000), tc::coxeter("5 3 5").solve({}, 5000, Strategy::HLT));
+    EXPECT_SAME_COSETS(tc::coxeter("-").solve({0}, 100), tc::coxeter("-").solve({0}, 100, Strategy::HLT));
+
+    EXPECT_SAME_COSETS(B(6).solve({}), B(6).solve({}, SIZE_MAX, Strategy::Stamp));
+    EXPECT_SAME_COSETS(D(6).solve({0, 3}), D(6).solve({0, 3}, SIZE_MAX, Strategy::Stamp));
+    EXPECT_SAME_COSETS(E(6).solve({}), E(6).solve({}, SIZE_MAX, Strategy::Stamp));
+    EXPECT_SAME_COSETS(H(4).solve({2}), H(4).solve({2}, SIZE_MAX, Strategy::Stamp));
+    EXPECT_SAME_COSETS(T(40, 30).solve({0}), T(40, 30).solve({0}, SIZE_MAX, Strategy::Stamp));
+    EXPECT_SAME_COSETS(I2(1000).solve({}), I2(1000).solve({}, SIZE_MAX, Strategy::Stamp));
+    EXPECT_SAME_COSETS(I2(7).solve({0, 1}), I2(7).solve({0, 1}, SIZE_MAX, Strategy::Stamp));
+    EXPECT_SAME_COSETS(H(4).solve({}, 1000), H(4).solve({}, 1000, Strategy::Stamp));
+    EXPECT_SAME_COSETS(tc::coxeter("5 3 5").solve({}, 5000), tc::coxeter("5 3 5").solve({}, 5000, Strategy::Stamp));
+}
+
+TEST(solve, scratch) {
+    tc::SolverWorkspace workspace(testing::TempDir());
+
+    EXPECT_SAME_COSETS(B(6).solve({}), B(6).solve({}, SIZE_MAX, workspace));
+    EXPECT_SAME_COSETS(E(6).solve({2}), E(6).solve({2}, SIZE_MAX, workspace));
+    EXPECT_SAME_COSETS(H(4).solve({}, 1000), H(4).solve({}, 1000, workspace));
+
+    // promotion and copies stay in scratch files.
+    auto mapped = T(400).solve({}, SIZE_MAX, workspace);
+    EXPECT_EQ(mapped.width(), 4);
+    tc::Cosets<> copy = mapped;
+    EXPECT_SAME_COSETS(T(400).solve({}), copy);
+}
+
+TEST(solve, snapshot) {
+    std::string path = testing::TempDir() + "tc_snapshot_test.cosets";
+
+    for (auto const &cosets: {E(6).solve({}), B(7).solve({0, 2}), H(4).solve({}, 1000), T(400).solve({})}) {
+        cosets.save(path);
+        auto mapped = tc::Cosets<>::map(path);
+
+        EXPECT_SAME_COSETS(cosets, mapped);
+        EXPECT_EQ(cosets.width(), mapped.width());
+
+        auto group = mapped.group();
+        ASSERT_EQ(group.rank(), cosets.rank());
+        EXPECT_SAME_COSETS(group.solve({}, cosets.order()), cosets.group().solve({}, cosets.order()));
+    }
+
+    // writes to a mapped table stay private to it.
+    E(6).solve({}).save(path);
+    auto mapped = tc::Cosets<>::map(path);
+    mapped.set(0, 0, 5);
+    EXPECT_EQ(tc::Cosets<>::map(path).get(0, 0), 1);
+
+    std::ofstream(path) << "not a table";
+    EXPECT_THROW(tc::Cosets<>::map(path), std::runtime_error);
+    EXPECT_THROW(tc::Cosets<>::map(path + ".missing"), std::runtime_error);
+
+    std::remove(path.c_str());
+}
+
+TEST(solve, cache) {
+    namespace fs = std::filesystem;
+    std::string dir = testing::TempDir() + "tc_cache_test";
+    fs::remove_all(dir);
+
+    auto cache = std::make_shared<tc::DiskCache>(dir, size_t(1) << 30);
+
+    tc::Group<> group = E(6);
+    group.use_cache(cache);
+    ASSERT_EQ(group.cache(), cache);
+
+    // repeats and order of the subgroup generators, and generators out of range, give the same key.
+    EXPECT_EQ(cache->path(tc::CacheKey(group, {2, 0, 2}, 100)), cache->path(tc::CacheKey(group, {0, 2, 9}, 100)));
+    EXPECT_NE(cache->path(tc::CacheKey(group, {0, 2}, 100)), cache->path(tc::CacheKey(group, {0, 3}, 100)));
+    EXPECT_NE(cache->path(tc::CacheKey(group, {}, 100)), cache->path(tc::CacheKey(B(6), {}, 100)));
+
+    auto fresh = E(6).solve({0, 2});
+    auto first = group.solve({2, 0});
+    EXPECT_TRUE(fs::exists(cache->path(tc::CacheKey(group, {0, 2}, SIZE_MAX))));
+    EXPECT_SAME_COSETS(first, fresh);
+    EXPECT_SAME_COSETS(group.solve({0, 2}), fresh);
+    EXPECT_SAME_COSETS(group.solve({0, 2}, SIZE_MAX, tc::Strategy::HLT), fresh);
+    EXPECT_SAME_COSETS(group.solve({0, 2}, SIZE_MAX, 2, true), fresh);
+
+    // incomplete tables are not stored.
+    EXPECT_FALSE(group.solve({}, 100).complete());
+    EXPECT_FALSE(fs::exists(cache->path(tc::CacheKey(group, {}, 100))));
+
+    // old entries are evicted once the directory is full.
+    auto small = std::make_shared<tc::DiskCache>(dir, fs::file_size(cache->path(tc::CacheKey(group, {0, 2}, SIZE_MAX))));
+    group.use_cache(small);
+    EXPECT_TRUE(group.solve({0, 2, 3}).complete());
+    EXPECT_TRUE(fs::exists(small->path(tc::CacheKey(group, {0, 2, 3}, SIZE_MAX))));
+    EXPECT_FALSE(fs::exists(small->path(tc::CacheKey(group, {0, 2}, SIZE_MAX))));
+
+    // an entry found under the file name of another key, as after a hash collision, is a miss.
+    tc::CacheKey stored(group, {0, 2, 3}, SIZE_MAX);
+    for (auto const &other: {tc::CacheKey(group, {0, 2, 4}, SIZE_MAX), tc::CacheKey(group, {0, 2, 3}, 100)}) {
+        fs::copy_file(small->path(stored), small->path(other), fs::copy_options::overwrite_existing);
+        EXPECT_FALSE(small->load(other));
+    }
+    EXPECT_TRUE(small->load(stored));
+
+    // a store that cannot replace its entry leaves no temporary file behind.
+    tc::CacheKey blocked(group, {1}, SIZE_MAX);
+    fs::create_directories(cache->path(blocked) + "/entry");
+    EXPECT_THROW(cache->store(blocked, E(6).solve({1})), fs::filesystem_error);
+    for (auto const &entry: fs::directory_iterator(dir)) {
+        EXPECT_EQ(entry.path().string().find(".tmp-"), std::string::npos) << entry.path();
+    }
+
+    fs::remove_all(dir);
+}
+
+TEST(solve, memory_cache) {
+    auto cache = std::make_shared<tc::MemoryCache>(size_t(1) << 30);
+
+    tc::Group<> group = E(6);
+    group.use_cache(cache);
+
+    auto fresh = E(6).solve({0, 2});
+    auto first = group.solve_shared({0, 2});
+    auto second = group.solve_shared({2, 0, 2});
+    EXPECT_EQ(first, second);
+    EXPECT_SAME_COSETS(*first, fresh);
+    EXPECT_SAME_COSETS(group.solve({0, 2}), fresh);
+    EXPECT_EQ(cache->hits(), 2);
+    EXPECT_EQ(cache->misses(), 1);
+    EXPECT_EQ(cache->bytes(), fresh.order() * fresh.rank() * fresh.width());
+
+    // every thread shares the one table.
+    std::vector<std::shared_ptr<tc::Cosets<> const>> results(4);
+    std::vector<std::thread> threads;
+    for (auto &res: results) {
+        threads.emplace_back([&] { res = group.solve_shared({0, 2}); });
+    }
+    for (auto &thread: threads) thread.join();
+    for (auto const &res: results) EXPECT_EQ(res, first);
+
+    // the least recently used table is dropped, but survives while it is shared.
+    auto small = std::make_shared<tc::MemoryCache>(cache->bytes());
+    group.use_cache(small);
+    auto old = group.solve_shared({0, 2});
+    EXPECT_TRUE(group.solve_shared({0, 2, 3})->complete());
+    EXPECT_NE(group.solve_shared({0, 2}), old);
+    EXPECT_SAME_COSETS(*old, fresh);
+    EXPECT_EQ(small->hits(), 0);
+
+    // misses fall through to the next cache.
+    std::string dir = testing::TempDir() + "tc_memory_cache_test";
+    auto disk = std::make_shared<tc::DiskCache>(dir, size_t(1) << 30);
+    group.use_cache(std::make_shared<tc::MemoryCache>(size_t(1) << 30, disk));
+    EXPECT_TRUE(group.solve({0, 2}).complete());
+    auto chained = std::make_shared<tc::MemoryCache>(size_t(1) << 30, disk);
+    group.use_cache(chained);
+    EXPECT_SAME_COSETS(*group.solve_shared({0, 2}), fresh);
+    EXPECT_EQ(chained->misses(), 1);
+    EXPECT_SAME_COSETS(*group.solve_shared({0, 2}), fresh);
+    EXPECT_EQ(chained->hits(), 1);
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(solve, solver) {
+    auto group = tc::coxeter("5 3 5");
+
+    tc::Solver solver(group, {0}, 1000);
+    EXPECT_EQ(solver.cosets().order(), 1000);
+    EXPECT_FALSE(solver.cosets().complete());
+
+    // extending gives the table a fresh solve with the larger bound gives, across index widths.
+    for (size_t bound: {1000, 5000, 5001, 70000}) {
+        EXPECT_SAME_COSETS(solver.extend(bound), group.solve({0}, bound));
+    }
+    EXPECT_SAME_COSETS(solver.extend(100), group.solve({0}, 70000));
+
+    tc::Solver finite(B(6), {0, 2}, 10);
+    EXPECT_SAME_COSETS(finite.extend(), B(6).solve({0, 2}));
+    EXPECT_TRUE(finite.cosets().complete());
+    EXPECT_SAME_COSETS(finite.extend(), B(6).solve({0, 2}));
+    EXPECT_SAME_COSETS(std::move(finite).release(), B(6).solve({0, 2}));
+
+    EXPECT_SAME_COSETS(tc::Solver(tc::Group<>(0), {}).cosets(), tc::Group<>(0).solve({}));
+}
+
+TEST(solve, options) {
+    using tc::StopReason;
+
+    auto group = tc::coxeter("5 3 5");
+
+    EXPECT_EQ(B(5).solve({}, tc::SolveOptions{}).stop_reason(), StopReason::Complete);
+    EXPECT_EQ(group.solve({}, 1000).stop_reason(), StopReason::Bound);
+
+    // progress is reported once every interval, with the same table as an unreported solve.
+    std::vector<tc::Progress> reports;
+    tc::SolveOptions options;
+    options.bound = 10000;
+    options.interval = 1000;
+    options.progress = [&](tc::Progress const &progress) { reports.push_back(progress); };
+    EXPECT_SAME_COSETS(group.solve({}, options), group.solve({}, 10000));
+    ASSERT_EQ(reports.size(), 10);
+    for (size_t k = 0; k < reports.size(); ++k) {
+        EXPECT_EQ(reports[k].cosets, std::max<size_t>(k * 1000, 1));
+        EXPECT_LE(reports[k].scan, reports[k].cosets);
+        EXPECT_EQ(reports[k].rows, reports[k].cosets - reports[k].scan);
+    }
+
+    std::atomic<bool> cancel = false;
+    options = {};
+    options.interval = 1000;
+    options.cancel = &cancel;
+    options.progress = [&](tc::Progress const &progress) { cancel = progress.cosets >= 5000; };
+    auto cancelled = group.solve({}, options);
+    EXPECT_EQ(cancelled.stop_reason(), StopReason::Cancelled);
+    EXPECT_EQ(cancelled.order(), 5000);
+
+    options = {};
+    options.deadline = std::chrono::steady_clock::now();
+    EXPECT_EQ(group.solve({}, options).stop_reason(), StopReason::Deadline);
+
+    options = {};
+    options.max_bytes = 1 << 20;
+    auto limited = group.solve({}, options);
+    EXPECT_EQ(limited.stop_reason(), StopReason::Memory);
+    EXPECT_LT(limited.size() * limited.width(), 2 << 20);
+
+    // a stopped solve can be resumed.
+    tc::Solver solver(group, {}, 0);
+    options = {};
+    options.max_bytes = 1 << 20;
+    EXPECT_EQ(solver.extend(options).stop_reason(), StopReason::Memory);
+    EXPECT_SAME_COSETS(solver.extend(100000), group.solve({}, 100000));
+    EXPECT_EQ(solver.cosets().stop_reason(), StopReason::Bound);
+}
+
+#ifdef TC_STATS
+TEST(solve, stats) {
+    auto cosets = B(6).solve({});
+    auto const &stats = cosets.stats();
+
+    // every fact is popped; each new coset starts from one fact that is never a duplicate.
+    EXPECT_EQ(stats.facts_pushed, stats.facts_popped);
+    EXPECT_EQ(stats.facts_pushed - stats.facts_skipped, cosets.order() * cosets.rank() / 2);
+    EXPECT_GE(stats.max_facts, 1);
+    EXPECT_GE(stats.max_live_rows, 1);
+    EXPECT_LE(stats.max_live_rows, cosets.order());
+    EXPECT_EQ(stats.loops_closed.size(), cosets.rank() - 1);  // commuting pairs need no relation table
+
+    EXPECT_EQ(B(6).solve({}, SIZE_MAX, tc::Strategy::HLT).stats().facts_pushed, 0);
+}
+#endif
+
+TEST(solve, consumer) {
+    // rows passed to the consumer are final, and each is passed once, in order.
+    auto stream = [](tc::Group<> const &group, std::vector<size_t> const &idxs, size_t bound) {
+        std::vector<size_t> rows;
+        size_t next = 0;
+        tc::SolveOptions options;
+        options.bound = bound;
+        options.interval = 100;
+        options.consumer = [&](tc::Cosets<> const &cosets, size_t begin, size_t end) {
+            EXPECT_EQ(begin, next);
+            EXPECT_LT(begin, end);
+            next = end;
+            for (size_t coset = begin; coset < end; ++coset) {
+                for (size_t gen = 0; gen < cosets.rank(); ++gen) {
+                    rows.push_back(cosets.get(coset, gen));
+                }
+            }
+        };
+        auto cosets = group.solve(idxs, options);
+
+        for (size_t k = 0; k < rows.size(); ++k) {
+            EXPECT_EQ(rows[k], cosets.get(k / cosets.rank(), k % cosets.rank()));
+        }
+        return rows.size() / std::max<size_t>(cosets.rank(), 1);
+    };
+
+    EXPECT_EQ(stream(E(6), {0}, SIZE_MAX), 25920);
+    EXPECT_EQ(stream(B(5), {}, SIZE_MAX), 3840);
+    EXPECT_EQ(stream(tc::Group<>(0), {}, SIZE_MAX), 0);
+    EXPECT_LE(stream(tc::coxeter("5 3 5"), {}, 5000), 5000);
+
+    // a cached table is passed whole.
+    tc::Group<> group = B(5);
+    group.use_cache(std::make_shared<tc::MemoryCache>(size_t(1) << 30));
+    EXPECT_EQ(stream(group, {}, SIZE_MAX), 3840);
+    EXPECT_EQ(stream(group, {}, SIZE_MAX), 3840);
+}
+
+TEST(solve, compose) {
+    auto check = [](tc::Group<> const &group, std::vector<size_t> const &k, std::vector<size_t> const &j) {
+        auto outer = group.solve(k);
+        auto inner = group.sub(k).solve(j);
+
+        std::vector<size_t> idxs;
+        for (size_t s: j) idxs.push_back(k[s]);
+        auto expected = group.solve(idxs);
+
+        auto cosets = group.compose(outer, inner);
+        EXPECT_TRUE(cosets.complete());
+        EXPECT_EQ(cosets.order(), outer.order() * inner.order());
+        EXPECT_EQ(cosets.order(), expected.order());
+        EXPECT_SAME_COSETS(group.compose(outer, inner, true), expected);
+    };
+
+    check(E(6), {0, 1, 2, 3, 4}, {});
+    check(E(6), {1, 2, 3, 4, 5}, {0, 2});
+    check(B(6), {0, 1, 2}, {0});
+    check(H(4), {1, 2, 3}, {});
+    check(D(6), {}, {});
+    check(A(5), {0, 1, 2, 3, 4}, {1, 3});
+    check(tc::coxeter("5 2 5"), {0, 3}, {1});
+
+    EXPECT_THROW(E(6).compose(E(6).solve({0}, 100), E(6).sub({0}).solve({})), std::invalid_argument);
+    EXPECT_THROW(E(6).compose(B(6).solve({0}), E(6).sub({0}).solve({})), std::invalid_argument);
+    EXPECT_THROW(E(6).compose(E(6).solve({0}), E(6).sub({0, 1}).solve({})), std::invalid_argument);
+}
+
+TEST(solve, kernels) {
+    // the kernels compiled for each rank give the same tables as the generic kernel.
+    tc::SolveOptions generic;
+    generic.bound = 100000;
+    generic.specialize = false;
+
+    for (auto const &group: {I2(7), A(3), B(4), F4(), A(5), D(6), E(7), B(8), A(9), tc::coxeter("5 3 5")}) {
+        EXPECT_SAME_COSETS(group.solve({}, 100000), group.solve({}, generic));
+        EXPECT_SAME_COSETS(group.solve({0}, 100000), group.solve({0}, generic));
+    }
+}
+
+TEST(solve, commuting) {
+    // long diagrams are almost all commuting pairs.
+    v most_a, most_d;
+    for (size_t s = 1; s < 40; ++s) most_a.push_back(s);
+    for (size_t s = 0; s < 29; ++s) most_d.push_back(s);
+
+    EXPECT_EQ(A(40).solve(most_a).order(), 41);
+    EXPECT_EQ(D(30).solve(most_d).order(), 60);
+    EXPECT_EQ(tc::coxeter("2 2 2 2").solve({}).order(), 32);
+    EXPECT_EQ(tc::coxeter("3 2 3 2 3").solve({0}).order(), 108);
+
+    EXPECT_SAME_COSETS(B(6).solve({1, 4}), B(6).solve({1, 4}, SIZE_MAX, tc::Strategy::HLT));
+    EXPECT_SAME_COSETS(A(50).solve({}, 20000), A(50).solve({}, 20000, tc::Strategy::HLT));
+}
+
+TEST(solve, automaton) {
+    // every element is accepted exactly once.
+    for (auto const &group: {H(3), B(4), A(5)}) {
+        auto cosets = group.solve({});
+        std::vector<bool> seen(cosets.order());
+
+        tc::Automaton automaton(group);
+        size_t count = automaton.walk(SIZE_MAX, SIZE_MAX, [&](v const &word) {
+            size_t coset = 0;
+            for (size_t gen: word) coset = cosets.get(coset, gen);
+            EXPECT_FALSE(seen[coset]);
+            seen[coset] = true;
+        });
+        EXPECT_EQ(count, cosets.order());
+    }
+
+    tc::Automaton dihedral(I2(3));
+    EXPECT_TRUE(dihedral.accepts({0, 1, 0}));
+    EXPECT_FALSE(dihedral.accepts({1, 0, 1}));
+    EXPECT_FALSE(dihedral.accepts({0, 0}));
+
+    // the affine group ~A_2 has 3n elements of length n > 0.
+    std::vector<size_t> lengths;
+    tc::Automaton affine(tc::coxeter("{3 3 3}"));
+    affine.walk(20, SIZE_MAX, [&](v const &word) {
+        if (lengths.size() <= word.size()) lengths.resize(word.size() + 1);
+        lengths[word.size()]++;
+    });
+    EXPECT_EQ(lengths.size(), 21);
+    for (size_t n = 1; n < lengths.size(); ++n) EXPECT_EQ(lengths[n], 3 * n);
+
+    // hyperbolic groups are walked in ShortLex order with a fixed automaton.
+    tc::Automaton hyperbolic(tc::coxeter("4 3 5"));
+    size_t last = 0;
+    EXPECT_EQ(hyperbolic.walk(SIZE_MAX, 10000, [&](v const &word) {
+        EXPECT_GE(word.size(), last);
+        last = word.size();
+    }), 10000);
+    EXPECT_EQ(hyperbolic.roots(), 25);
+    EXPECT_LT(hyperbolic.states(), 1000);
+}
+
+TEST(solve, depth) {
+    auto bfs = [](tc::Cosets<> const &cosets) {
+        std::vector<size_t> depth(cosets.order(), SIZE_MAX);
+        std::vector<size_t> queue = {0};
+        depth[0] = 0;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            for (size_t gen = 0; gen < cosets.rank(); ++gen) {
+                size_t target = cosets.get(queue[head], gen);
+                if (target == tc::Cosets<>::UNSET || depth[target] != SIZE_MAX) continue;
+                depth[target] = depth[queue[head]] + 1;
+                queue.push_back(target);
+            }
+        }
+        return depth;
+    };
+
+    tc::SolveOptions options;
+    options.depth = true;
+
+    for (auto const &group: {B(6), E(6), H(4), T(40, 30)}) {
+        auto cosets = group.solve({}, options);
+        ASSERT_TRUE(cosets.has_depth());
+
+        auto expected = bfs(cosets);
+        for (size_t coset = 0; coset < cosets.order(); ++coset) {
+            ASSERT_EQ(cosets.depth(coset), expected[coset]);
+        }
+    }
+    EXPECT_EQ(H(4).solve({}, options).depth(14399), 60);
+    EXPECT_EQ(I2(1000).solve({}, options).depth(1999), 1000);
+
+    auto plain = B(4).solve({});
+    EXPECT_FALSE(plain.has_depth());
+    EXPECT_THROW((void) plain.depth(0), std::logic_error);
+
+    // a solver that starts without depths records them from the first extend that asks.
+    tc::Solver solver(E(6), {}, 1000);
+    solver.extend(options);
+    auto expected = bfs(solver.cosets());
+    for (size_t coset = 0; coset < solver.cosets().order(); ++coset) {
+        ASSERT_EQ(solver.cosets().depth(coset), expected[coset]);
+    }
+
+    // depths past 65535 are widened with the table.
+    options.bound = 140000;
+    auto line = tc::coxeter("-").solve({0}, options);
+    EXPECT_EQ(line.width(), 4);
+    EXPECT_EQ(line.depth(1000), 1000);
+    EXPECT_EQ(line.depth(65535), 65535);
+    EXPECT_EQ(line.depth(line.order() - 1), line.order() - 1);
+}
+
+TEST(solve, path) {
+    tc::SolveOptions options;
+    options.depth = true;
+    options.path = true;
+
+    for (auto const &group: {B(6), E(6), H(4)}) {
+        auto cosets = group.solve({}, options);
+        auto const &path = cosets.path();
+        ASSERT_EQ(path.order(), cosets.order());
+
+        for (size_t coset = 1; coset < cosets.order(); ++coset) {
+            ASSERT_LT(path.parent(coset), coset);
+            ASSERT_EQ(cosets.get(path.parent(coset), path.gen(coset)), coset);
+        }
+        for (size_t level = 0; level < path.levels(); ++level) {
+            EXPECT_EQ(cosets.depth(path.level(level)), level);
+            EXPECT_EQ(cosets.depth(path.level(level + 1) - 1), level);
+        }
+
+        // each coset is reached from coset 0 by the product of the generators along its path.
+        v gens = {0, 1, 2, 3, 4, 5};
+        for (unsigned threads: {1u, 4u}) {
+            auto targets = path.walk(size_t(0), gens, [&](size_t coset, size_t gen) {
+                return cosets.get(coset, gen);
+            }, threads);
+            for (size_t coset = 0; coset < cosets.order(); ++coset) {
+                ASSERT_EQ(targets[coset], coset);
+            }
+        }
+    }
+
+    // D_7 has levels large enough to be split across threads.
+    auto large = D(7).solve({}, options);
+    auto depths = large.path().walk(size_t(0), v(7, 1), std::plus<>(), 4);
+    for (size_t coset = 0; coset < large.order(); ++coset) {
+        ASSERT_EQ(depths[coset], large.depth(coset));
+    }
+
+    EXPECT_EQ(H(4).solve({}, options).path().levels(), 61);
+    EXPECT_FALSE(B(4).solve({}).has_path());
+    EXPECT_THROW((void) B(4).solve({}).path(), std::logic_error);
+
+    // a path recorded after the fact matches the one recorded during the solve.
+    tc::Solver solver(E(6), {}, 1000);
+    auto const &late = solver.extend(options).path();
+    auto full = E(6).solve({}, options);
+    auto const &early = full.path();
+    ASSERT_EQ(late.order(), early.order());
+    for (size_t coset = 1; coset < early.order(); ++coset) {
+        ASSERT_EQ(late.parent(coset), early.parent(coset));
+        ASSERT_EQ(late.gen(coset), early.gen(coset));
+    }
+}
+
+TEST(solve, labels) {
+    enum class Mirror { R, G, B, Y };
+
+    tc::Group<char> chars(tc::coxeter("5 3 3"), {'r', 'g', 'b', 'y'});
+    tc::Group<Mirror> mirrors(tc::coxeter("5 3 3"), {Mirror::R, Mirror::G, Mirror::B, Mirror::Y});
+    tc::Group<long> sparse(tc::coxeter("5 3 3"), {-7, 1000000, 3, 1L << 40});
+    tc::Group<std::string> names(tc::coxeter("5 3 3"), {"red", "green", "blue", "yellow"});
+
+    EXPECT_EQ(chars.get('r', 'g'), 5);
+    EXPECT_EQ(mirrors.get(Mirror::G, Mirror::B), 3);
+    EXPECT_EQ(sparse.get(1000000, 3), 3);
+    EXPECT_EQ(sparse.get(-7, 1L << 40), 2);
+    EXPECT_EQ(names.get("blue", "yellow"), 3);
+
+    auto raw = tc::coxeter("5 3 3").solve({1});
+    auto cosets = names.solve({"green"});
+    auto by_char = chars.solve({'g'});
+    ASSERT_EQ(cosets.order(), raw.order());
+    for (size_t coset = 0; coset < raw.order(); ++coset) {
+        EXPECT_EQ(cosets.get(coset, "red"), raw.get(coset, 0));
+        EXPECT_EQ(cosets.get(coset, "yellow"), raw.get(coset, 3));
+        EXPECT_EQ(by_char.get(coset, 'b'), raw.get(coset, 2));
+    }
+
+    // every labelled solve indexes the group's generators, including solve_all.
+    auto all = names.solve_all({{"green"}});
+    ASSERT_EQ(all[0].order(), raw.order());
+    for (size_t coset = 0; coset < raw.order(); ++coset) {
+        EXPECT_EQ(all[0].get(coset, "red"), raw.get(coset, 0));
+        EXPECT_EQ(all[0].get(coset, "green"), raw.get(coset, 1));
+    }
+
+    // a repeated generator has the index of its first occurrence.
+    tc::Group<int> repeated(3, {4, 9, 4});
+    repeated.set(9, 4, 5);
+    EXPECT_EQ(repeated.get(4, 9), 5);
+    EXPECT_EQ(repeated.Group<>::get(2, 1), 2);
+}
+
+TEST(solve, classify) {
+    auto names = [](tc::Group<> const &group) {
+        std::vector<std::string> res;
+        for (auto const &component: group.classify()) {
+            res.push_back(component.name());
+        }
+        return res;
+    };
+
+    tc::Group<> triangle(3);
+    triangle.set(0, 1, 3);
+    triangle.set(1, 2, 3);
+    triangle.set(0, 2, 3);
+
+    tc::Group<> free(2);
+    free.set(0, 1, tc::FREE);
+
+    using s = std::vector<std::string>;
+    EXPECT_EQ(names(A(5)), s({"A5"}));
+    EXPECT_EQ(names(B(6)), s({"B6"}));
+    EXPECT_EQ(names(D(6)), s({"D6"}));
+    EXPECT_EQ(names(E(8)), s({"E8"}));
+    EXPECT_EQ(names(F4()), s({"F4"}));
+    EXPECT_EQ(names(G2()), s({"I2(6)"}));
+    EXPECT_EQ(names(H(4)), s({"H4"}));
+    EXPECT_EQ(names(T(5, 7)), s({"I2(5)", "I2(7)"}));
+    EXPECT_EQ(names(tc::coxeter("4 3 4")), s({"affine"}));
+    EXPECT_EQ(names(tc::coxeter("6 3")), s({"affine"}));
+    EXPECT_EQ(names(triangle), s({"affine"}));
+    EXPECT_EQ(names(free), s({"affine"}));
+    EXPECT_EQ(names(tc::coxeter("5 3 5")), s({"other"}));
+    EXPECT_EQ(names(tc::coxeter("3 7")), s({"other"}));
+    EXPECT_TRUE(tc::Group<>(0).classify().empty());
+
+    auto e6 = E(6).classify();
+    ASSERT_EQ(e6.size(), 1);
+    EXPECT_EQ(e6[0].family, 'E');
+    EXPECT_EQ(e6[0].gens, v({0, 1, 2, 3, 4, 5}));
+    EXPECT_EQ(e6[0].order(), 51840);
+    EXPECT_EQ(tc::coxeter("5 3 5").classify()[0].order(), std::nullopt);
+
+    // the order from the diagram is the order of the table.
+    for (auto const &group: {A(5), B(6), D(5), E(6), F4(), H(4), T(5, 7)}) {
+        for (auto const &idxs: {v({}), v({0}), v({1, 3}), v({0, 1, 2})}) {
+            EXPECT_EQ(group.order(idxs), group.solve(idxs).order());
+        }
+    }
+    EXPECT_EQ(E(8).order(), 696729600);
+    EXPECT_EQ(A(25).order(), SIZE_MAX);
+    EXPECT_EQ(A(25).order(v({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23})), 26);
+
+    // an infinite component has a finite index only over all of its generators.
+    tc::Group<> product(4);
+    product.set(0, 1, tc::FREE);
+    product.set(2, 3, 3);
+    EXPECT_EQ(product.order({0}), std::nullopt);
+    EXPECT_EQ(product.order({0, 1}), 6);
+    EXPECT_EQ(product.order({0, 1, 2}), 3);
+    EXPECT_EQ(product.solve({0, 1}).order(), 6);
+    EXPECT_EQ(tc::coxeter("5 3 5").order({0, 1, 2, 3}), 1);
+
+    // a solve that could never stop is rejected; any limit allows it.
+    auto hyperbolic = tc::coxeter("5 3 5");
+    EXPECT_THROW((void) hyperbolic.solve({}), std::invalid_argument);
+    EXPECT_THROW((void) hyperbolic.solve({0}, SIZE_MAX, tc::Strategy::HLT), std::invalid_argument);
+    EXPECT_THROW((void) hyperbolic.solve({0}, SIZE_MAX, 2), std::invalid_argument);
+    EXPECT_THROW(tc::Solver(hyperbolic, {0}), std::invalid_argument);
+    EXPECT_EQ(hyperbolic.solve({}, 100).order(), 100);
+
+    tc::Solver solver(hyperbolic, {}, 100);
+    EXPECT_THROW(solver.extend(), std::invalid_argument);
+    EXPECT_EQ(solver.extend(200).order(), 200);
+}
+
+TEST(solve, growth) {
+    // the number of cosets at each distance from coset 0, as far as the table is complete.
+    auto levels = [](tc::Group<> const &group, std::vector<size_t> const &idxs, size_t bound) {
+        tc::SolveOptions options;
+        options.bound = bound;
+        options.depth = true;
+        auto cosets = group.solve(idxs, options);
+
+        std::vector<size_t> res;
+        for (size_t coset = 0; coset < cosets.order(); ++coset) {
+            if (res.size() <= cosets.depth(coset)) res.resize(cosets.depth(coset) + 1, 0);
+            res[cosets.depth(coset)]++;
+        }
+        if (!cosets.complete()) res.pop_back();
+        return res;
+    };
+
+    // finite coset spaces give a polynomial whose coefficients sum to the order.
+    for (auto const &group: {B(4), D(5), E(6), H(3), T(5, 7)}) {
+        for (auto const &idxs: {v({}), v({0}), v({1, 3})}) {
+            auto growth = group.growth(idxs);
+            auto expected = levels(group, idxs, SIZE_MAX);
+            EXPECT_EQ(growth.denom, std::vector<int64_t>({1}));
+            EXPECT_EQ(growth.numer.size(), expected.size());
+            EXPECT_EQ(growth.expand(expected.size()), expected);
+            EXPECT_EQ(growth.expand(expected.size() + 1).back(), 0);
+        }
+    }
+    EXPECT_EQ(E(8).growth().expand(121).back(), 1);  // the longest element
+
+    tc::Group<> free(2);
+    free.set(0, 1, tc::FREE);
+    EXPECT_EQ(free.growth().numer, std::vector<int64_t>({1, 1}));
+    EXPECT_EQ(free.growth().denom, std::vector<int64_t>({1, -1}));
+    EXPECT_EQ(free.growth({0}).expand(5), v({1, 1, 1, 1, 1}));
+
+    // infinite groups agree with the normal forms of each length, and with the complete levels of a bounded table.
+    for (auto const &symbol: {"6 3", "4 3 5", "5 3 5", "3 5 3", "5 3 3 3", "4 4 4"}) {
+        auto group = tc::coxeter(symbol);
+
+        tc::Automaton automaton(group);
+        std::vector<size_t> words(13, 0);
+        automaton.walk(12, SIZE_MAX, [&](std::vector<size_t> const &word) { words[word.size()]++; });
+        EXPECT_EQ(group.growth().expand(13), words) << symbol;
+
+        for (auto const &idxs: {v({0}), v({0, 2})}) {
+            auto expected = levels(group, idxs, 20000);
+            EXPECT_EQ(group.growth(idxs).expand(expected.size()), expected) << symbol;
+        }
+    }
+
+    // components inside the subgroup drop out.
+    tc::Group<> product(4);
+    product.set(0, 1, tc::FREE);
+    product.set(2, 3, 3);
+    EXPECT_EQ(product.growth({0, 1}).numer, std::vector<int64_t>({1, 2, 2, 1}));
+    EXPECT_EQ(product.growth({0, 1}).denom, std::vector<int64_t>({1}));
+    EXPECT_EQ(product.growth({2}).expand(5), v({1, 3, 5, 6, 6}));
+
+    // the free product of three reflections has 3 * 2^(k-1) elements of length k.
+    tc::Group<> wide(3);
+    wide.set(0, 1, tc::FREE);
+    wide.set(1, 2, tc::FREE);
+    wide.set(0, 2, tc::FREE);
+    EXPECT_EQ(wide.growth().expand(62).back(), 3 * (size_t(1) << 60));
+    EXPECT_THROW((void) wide.growth().expand(64), std::overflow_error);
+}
+
 TEST(solve_large, B) {
     EXPECT_SOLVE_ORDER(B(7), v({}), 645120);
     EXPECT_SOLVE_ORDER(B(8), v({}), 10321920);